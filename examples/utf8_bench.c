@@ -0,0 +1,175 @@
+/* OCFX Example - UTF-8 Benchmark
+ * Times the library's decode, count and validate against a byte-at-a-time
+ * reference on ASCII log text and on mixed-script text.
+ */
+
+#define _POSIX_C_SOURCE 200809L  /* For clock_gettime */
+
+#include <ocfx/ocfx.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_BYTES (8u << 20)
+#define BENCH_ROUNDS 20
+#define BENCH_CHUNK 128
+
+/* Byte-at-a-time reference (the decoder the library used before) */
+static uint32_t ref_decode(const char **str) {
+    const unsigned char *s = (const unsigned char *)*str;
+    uint32_t codepoint;
+    int bytes;
+
+    if (!*s) return 0;
+    if ((*s & 0x80) == 0) {
+        codepoint = *s;
+        bytes = 1;
+    } else if ((*s & 0xE0) == 0xC0) {
+        if ((s[1] & 0xC0) != 0x80) return 0;
+        codepoint = ((uint32_t)(s[0] & 0x1F) << 6) | (s[1] & 0x3F);
+        bytes = 2;
+    } else if ((*s & 0xF0) == 0xE0) {
+        if ((s[1] & 0xC0) != 0x80 || (s[2] & 0xC0) != 0x80) return 0;
+        codepoint = ((uint32_t)(s[0] & 0x0F) << 12) | ((uint32_t)(s[1] & 0x3F) << 6) |
+                    (s[2] & 0x3F);
+        bytes = 3;
+    } else if ((*s & 0xF8) == 0xF0) {
+        if ((s[1] & 0xC0) != 0x80 || (s[2] & 0xC0) != 0x80 || (s[3] & 0xC0) != 0x80) return 0;
+        codepoint = ((uint32_t)(s[0] & 0x07) << 18) | ((uint32_t)(s[1] & 0x3F) << 12) |
+                    ((uint32_t)(s[2] & 0x3F) << 6) | (s[3] & 0x3F);
+        bytes = 4;
+    } else {
+        codepoint = '?';
+        bytes = 1;
+    }
+
+    *str += bytes;
+    return codepoint;
+}
+
+static size_t ref_count(const char *text) {
+    size_t count = 0;
+    while (ref_decode(&text)) count++;
+    return count;
+}
+
+static bool ref_validate(const char *text, size_t len) {
+    const char *end = text + len;
+    while (text < end && *text) {
+        const unsigned char *s = (const unsigned char *)text;
+        int bytes;
+        if ((*s & 0x80) == 0) bytes = 1;
+        else if ((*s & 0xE0) == 0xC0) bytes = 2;
+        else if ((*s & 0xF0) == 0xE0) bytes = 3;
+        else if ((*s & 0xF8) == 0xF0) bytes = 4;
+        else return false;
+        if (end - text < bytes) return false;
+        for (int i = 1; i < bytes; i++) {
+            if ((s[i] & 0xC0) != 0x80) return false;
+        }
+        text += bytes;
+    }
+    return true;
+}
+
+static uint64_t ref_decode_all(const char *text, size_t len) {
+    const char *end = text + len;
+    uint64_t sum = 0;
+    while (text < end && *text) {
+        uint32_t cp = ref_decode(&text);
+        if (!cp) break;
+        sum += cp;
+    }
+    return sum;
+}
+
+static uint64_t lib_decode_all(const char *text, size_t len) {
+    uint32_t codepoints[BENCH_CHUNK];
+    uint64_t sum = 0;
+    size_t consumed;
+    size_t n;
+    while ((n = ocfx_text_utf8_decode(text, len, codepoints, BENCH_CHUNK, &consumed)) > 0) {
+        for (size_t i = 0; i < n; i++) sum += codepoints[i];
+        text += consumed;
+        len -= consumed;
+    }
+    return sum;
+}
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec / 1e6;
+}
+
+/* Fill buf with repeated copies of sample (NUL terminated) */
+static char* make_text(const char *sample) {
+    char *buf = malloc(BENCH_BYTES + 1);
+    if (!buf) return NULL;
+    size_t sample_len = strlen(sample);
+    size_t len = 0;
+    while (len + sample_len <= BENCH_BYTES) {
+        memcpy(buf + len, sample, sample_len);
+        len += sample_len;
+    }
+    buf[len] = '\0';
+    return buf;
+}
+
+static void report(const char *name, double ms, size_t len) {
+    printf("  %-18s %8.2f ms/pass  %7.0f MB/s\n", name, ms,
+           (double)len / (1 << 20) / (ms / 1e3));
+}
+
+static void run(const char *label, const char *text) {
+    size_t len = strlen(text);
+    volatile uint64_t sink = 0;
+    double start;
+
+    printf("%s (%zu bytes, %zu codepoints)\n", label, len, ocfx_text_utf8_char_count(text));
+
+    start = now_ms();
+    for (int r = 0; r < BENCH_ROUNDS; r++) sink += ref_count(text);
+    report("count (ref)", (now_ms() - start) / BENCH_ROUNDS, len);
+    start = now_ms();
+    for (int r = 0; r < BENCH_ROUNDS; r++) sink += ocfx_text_utf8_char_count(text);
+    report("count", (now_ms() - start) / BENCH_ROUNDS, len);
+
+    start = now_ms();
+    for (int r = 0; r < BENCH_ROUNDS; r++) sink += ref_validate(text, len);
+    report("validate (ref)", (now_ms() - start) / BENCH_ROUNDS, len);
+    start = now_ms();
+    for (int r = 0; r < BENCH_ROUNDS; r++) sink += ocfx_text_is_valid_utf8(text, len);
+    report("validate", (now_ms() - start) / BENCH_ROUNDS, len);
+
+    start = now_ms();
+    for (int r = 0; r < BENCH_ROUNDS; r++) sink += ref_decode_all(text, len);
+    report("decode (ref)", (now_ms() - start) / BENCH_ROUNDS, len);
+    start = now_ms();
+    for (int r = 0; r < BENCH_ROUNDS; r++) sink += lib_decode_all(text, len);
+    report("decode", (now_ms() - start) / BENCH_ROUNDS, len);
+
+    if (ref_decode_all(text, len) != lib_decode_all(text, len)) {
+        printf("  MISMATCH between reference and library decode\n");
+    }
+    (void)sink;
+}
+
+int main(void) {
+    char *ascii = make_text(
+        "2024-05-01 12:00:03.512 INFO  [net] connection 42 accepted from 10.0.0.7:51812\n");
+    char *mixed = make_text(
+        "Grüße aus Köln — Привет, мир — こんにちは世界 — 🙂 ok\n");
+    if (!ascii || !mixed) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    run("ASCII log text", ascii);
+    run("Mixed-script text", mixed);
+
+    free(ascii);
+    free(mixed);
+    return 0;
+}
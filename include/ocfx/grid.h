@@ -0,0 +1,58 @@
+/* OCFX - Cell Grid Interface
+ * Terminal-style monospace text grid drawn with one instanced pass
+ */
+
+#ifndef OCFX_GRID_H
+#define OCFX_GRID_H
+
+#include "types.h"
+#include "render.h"
+#include "text.h"
+
+/* Forward declaration */
+typedef struct ocfx_grid_t ocfx_grid_t;
+
+/* Cell attributes */
+#define OCFX_GRID_UNDERLINE 0x1u
+#define OCFX_GRID_STRIKE    0x2u
+#define OCFX_GRID_INVERSE   0x4u      /* Swap foreground and background */
+
+/* One character cell (codepoint 0 or ' ' draws only the background) */
+typedef struct {
+    uint32_t codepoint;
+    ocfx_color_t fg;
+    ocfx_color_t bg;
+    uint32_t attrs;               /* OCFX_GRID_* */
+} ocfx_grid_cell_t;
+
+/* Grid lifetime. Cells are sized from the font (advance of 'M' by font
+ * height); the grid must be destroyed before its font. */
+ocfx_grid_t* ocfx_grid_create(ocfx_renderer_t *renderer, ocfx_font_t *font, int cols, int rows);
+void ocfx_grid_destroy(ocfx_grid_t *grid);
+
+/* Resize keeps the top-left content; new cells take the clear colors */
+bool ocfx_grid_resize(ocfx_grid_t *grid, int cols, int rows);
+void ocfx_grid_get_size(ocfx_grid_t *grid, int *cols, int *rows);
+void ocfx_grid_get_cell_size(ocfx_grid_t *grid, float *width, float *height);
+
+/* Cell access. Writing a cell with its current contents is free; only
+ * changed cells are re-uploaded on the next draw. */
+void ocfx_grid_set_cell(ocfx_grid_t *grid, int col, int row, const ocfx_grid_cell_t *cell);
+const ocfx_grid_cell_t* ocfx_grid_get_cell(ocfx_grid_t *grid, int col, int row);
+
+/* Write UTF-8 text from (col, row), one codepoint per cell, stopping at
+ * the end of the row. Returns the number of cells written. */
+int ocfx_grid_write(ocfx_grid_t *grid, int col, int row, const char *text,
+                    ocfx_color_t fg, ocfx_color_t bg, uint32_t attrs);
+
+/* Blank every cell and make fg/bg the colors of rows scrolled in */
+void ocfx_grid_clear(ocfx_grid_t *grid, ocfx_color_t fg, ocfx_color_t bg);
+
+/* Move content up (lines > 0) or down (lines < 0); rows scrolled in are
+ * blank. Only those rows are re-uploaded, the rest stay on the GPU. */
+void ocfx_grid_scroll(ocfx_grid_t *grid, int lines);
+
+/* Draw with the top-left corner of cell (0, 0) at (x, y) */
+void ocfx_grid_draw(ocfx_grid_t *grid, float x, float y);
+
+#endif /* OCFX_GRID_H */
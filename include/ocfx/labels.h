@@ -0,0 +1,49 @@
+/* OCFX - Label Layer Interface
+ * Priority-based label placement with collision culling (maps, graphs)
+ */
+
+#ifndef OCFX_LABELS_H
+#define OCFX_LABELS_H
+
+#include "types.h"
+#include "render.h"
+#include "text.h"
+
+/* Forward declaration */
+typedef struct ocfx_label_layer_t ocfx_label_layer_t;
+
+/* A layer collects candidate labels, then places them in priority order,
+ * rejecting any whose box overlaps one already placed. Overlap tests go
+ * through a uniform grid over the viewport, so placing n labels costs
+ * about O(n log n) instead of O(n^2). The layer must be destroyed before
+ * its font. */
+ocfx_label_layer_t* ocfx_label_layer_create(ocfx_font_t *font);
+void ocfx_label_layer_destroy(ocfx_label_layer_t *layer);
+
+/* Remove all candidates (keeps the memory for the next frame) */
+void ocfx_label_layer_clear(ocfx_label_layer_t *layer);
+
+/* Minimum gap kept between placed labels, in pixels (default 2) */
+void ocfx_label_layer_set_padding(ocfx_label_layer_t *layer, float padding);
+
+/* Add a candidate anchored at (x, y): align picks which side of the label
+ * touches x, and the label is centered vertically on y. Higher priorities
+ * are placed first; ties go to the earlier label. The text is copied.
+ * Returns the label's index, or SIZE_MAX on failure. */
+size_t ocfx_label_layer_add(ocfx_label_layer_t *layer, const char *text, size_t len,
+                            float x, float y, ocfx_text_align_t align,
+                            float priority, ocfx_color_t color);
+
+/* Place the candidates inside viewport (labels wholly outside it are
+ * dropped). Returns the number placed. */
+size_t ocfx_label_layer_place(ocfx_label_layer_t *layer, ocfx_rect_t viewport);
+
+/* Results of the last placement */
+size_t ocfx_label_layer_count(ocfx_label_layer_t *layer);
+bool ocfx_label_layer_is_placed(ocfx_label_layer_t *layer, size_t index);
+ocfx_rect_t ocfx_label_layer_get_bounds(ocfx_label_layer_t *layer, size_t index);
+
+/* Draw the placed labels into the renderer's text batch */
+void ocfx_label_layer_draw(ocfx_renderer_t *renderer, ocfx_label_layer_t *layer);
+
+#endif /* OCFX_LABELS_H */
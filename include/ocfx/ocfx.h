@@ -14,6 +14,10 @@
 #include "ocfx/wayland.h"
 #include "ocfx/render.h"
 #include "ocfx/text.h"
+#include "ocfx/grid.h"
+#include "ocfx/textview.h"
+#include "ocfx/textedit.h"
+#include "ocfx/labels.h"
 #include "ocfx/input.h"
 
 /* Utility functions */
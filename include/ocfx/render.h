@@ -20,6 +20,7 @@ void ocfx_renderer_destroy(ocfx_renderer_t *renderer);
 void ocfx_render_begin(ocfx_renderer_t *renderer, ocfx_color_t clear_color);
 void ocfx_render_end(ocfx_renderer_t *renderer);
 void ocfx_render_present(ocfx_renderer_t *renderer);
+uint64_t ocfx_render_get_frame(ocfx_renderer_t *renderer);  /* Incremented by render_begin */
 
 /* Viewport */
 void ocfx_render_set_viewport(ocfx_renderer_t *renderer, int32_t width, int32_t height);
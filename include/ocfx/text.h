@@ -14,8 +14,84 @@ typedef struct ocfx_font_t ocfx_font_t;
 /* Font loading */
 ocfx_font_t* ocfx_font_load(ocfx_renderer_t *renderer, const char *font_path, int size);
 ocfx_font_t* ocfx_font_load_system(ocfx_renderer_t *renderer, const char *font_name, int size);
+
+/* Installed font for a name: "Family" or "Family:Style" (e.g.
+ * "DejaVu Sans:Bold"), or a generic monospace, sans-serif or serif. The
+ * font directories are scanned once and the index is cached in
+ * $XDG_CACHE_HOME/ocfx, keyed by directory modification times, so later
+ * lookups are a hash probe. ocfx_font_load_system loads the result,
+ * falling back to a built-in monospace list. */
+bool ocfx_font_find_system(const char *font_name, char *path, size_t path_size);
+
+/* Subpixel-positioned font for small text: advances keep their fraction
+ * instead of rounding to whole pixels, and each glyph is rasterized at
+ * OCFX_SUBPIXEL_PHASES (4) horizontal offsets, cached as separate atlas
+ * entries. Drawing picks the phase nearest the pen, so spacing follows
+ * the font's design widths and measured widths match drawn ones. Uses up
+ * to four times the atlas space of ocfx_font_load. */
+ocfx_font_t* ocfx_font_load_subpixel(ocfx_renderer_t *renderer, const char *font_path,
+                                     int size);
+
+/* Signed distance field font: glyphs are generated once at the given size
+ * and stay crisp at any scale or transform (see ocfx_text_draw_scaled).
+ * Metrics are reported at the load size. */
+ocfx_font_t* ocfx_font_load_sdf(ocfx_renderer_t *renderer, const char *font_path, int size);
+bool ocfx_font_is_sdf(ocfx_font_t *font);
+
+/* Append a font to the fallback chain: codepoints the font lacks are drawn
+ * and measured with the first fallback that has them. Each face keeps a
+ * coverage bitmap of its cmap, so picking the font is a bit test per
+ * fallback. Fallbacks must share the font's renderer, mode (bitmap or
+ * SDF) and positioning (subpixel or not), are not owned and must outlive
+ * it. Add them before the font's first draw: runs and layouts cached
+ * earlier keep their old glyphs. */
+bool ocfx_font_add_fallback(ocfx_font_t *font, ocfx_font_t *fallback);
+
+/* Baked font compiled offline by ocfx-fontc (make fontc). The file is
+ * mapped and drawn from in place; no FreeType is involved, so this is the
+ * only loader left in builds made with FREETYPE=0. */
+ocfx_font_t* ocfx_font_load_baked(ocfx_renderer_t *renderer, const char *path);
 void ocfx_font_destroy(ocfx_font_t *font);
 
+/* Glyph atlas memory cap in bytes. All fonts of a renderer share one
+ * atlas; it grows up to the cap, then recycles the least recently used page. */
+void ocfx_text_set_atlas_limit(ocfx_renderer_t *renderer, size_t max_bytes);
+
+/* Per-frame cap on new glyph work: bitmap bytes rasterized/uploaded and
+ * milliseconds spent (0 = no cap). Glyphs over budget draw as a blank
+ * advance and are filled in on following frames, so a burst of new text
+ * is spread out instead of stalling one frame. OCFX_GLYPH_WAIT ignores it. */
+void ocfx_text_set_frame_budget(ocfx_renderer_t *renderer, size_t max_bytes, float max_ms);
+
+/* On-disk glyph cache. Fonts loaded while a directory is set map their
+ * cached glyphs (keyed by font file hash, size and mode) into the atlas in
+ * one upload, and write newly rasterized glyphs back when destroyed or on
+ * ocfx_font_save_cache. NULL disables caching for fonts loaded afterwards. */
+void ocfx_text_set_cache_dir(const char *dir);
+bool ocfx_font_save_cache(ocfx_font_t *font);
+
+/* Background glyph rasterization. With a mode other than SYNC, missing
+ * glyphs are rendered by worker threads (workers <= 0 picks one per spare
+ * core) and only uploaded on the render thread. PLACEHOLDER draws a blank
+ * advance until a glyph arrives (usually the next frame); WAIT queues all
+ * missing glyphs of a string and blocks until they are ready. */
+typedef enum {
+    OCFX_GLYPH_SYNC,              /* Rasterize inside the draw call (default) */
+    OCFX_GLYPH_PLACEHOLDER,
+    OCFX_GLYPH_WAIT,
+} ocfx_glyph_loading_t;
+
+bool ocfx_text_set_glyph_loading(ocfx_glyph_loading_t mode, int workers);
+
+/* Inclusive codepoint range */
+typedef struct {
+    uint32_t first, last;
+} ocfx_codepoint_range_t;
+
+/* Rasterize whole ranges ahead of time (in the background when a worker
+ * mode is set, otherwise right away) */
+void ocfx_font_prewarm(ocfx_font_t *font, const ocfx_codepoint_range_t *ranges, size_t count);
+
 /* Font metrics */
 int ocfx_font_get_height(ocfx_font_t *font);
 int ocfx_font_get_advance(ocfx_font_t *font);
@@ -27,12 +103,94 @@ void ocfx_text_measure(ocfx_font_t *font, const char *text, float *width, float
 void ocfx_text_measure_n(ocfx_font_t *font, const char *text, size_t len,
                          float *width, float *height);
 
-/* Text rendering */
+/* Measure count strings in one call: texts[i] is NUL terminated, or
+ * lens[i] bytes long when lens is given. widths (optional) receives each
+ * width; the widest is returned (e.g. for sizing a table column). */
+float ocfx_text_measure_batch(ocfx_font_t *font, const char *const *texts,
+                              const size_t *lens, size_t count, float *widths);
+
+/* Caret positions of text[0, len): prefix[i] is the x before codepoint i,
+ * prefix[n] the total width, for the n <= max codepoints returned (prefix
+ * needs max + 1 entries). NUL bytes are skipped as in the _n draws. */
+size_t ocfx_text_prefix_advances(ocfx_font_t *font, const char *text, size_t len,
+                                 float *prefix, size_t max);
+
+/* Caret index (0..count) nearest to x, by binary search over the
+ * count + 1 positions from ocfx_text_prefix_advances */
+size_t ocfx_text_hit_test(const float *prefix, size_t count, float x);
+
+/* Text rendering. The _n variants take a string view (pointer + length,
+ * e.g. a slice of a mapped file) and draw it in place without copying;
+ * NUL bytes inside the view are skipped. */
 void ocfx_text_draw(ocfx_renderer_t *renderer, ocfx_font_t *font,
                     const char *text, float x, float y, ocfx_color_t color);
 void ocfx_text_draw_n(ocfx_renderer_t *renderer, ocfx_font_t *font,
                       const char *text, size_t len, float x, float y, ocfx_color_t color);
 
+/* Scaled / transformed text. The transform maps text-local coordinates
+ * (origin at the top-left of the text) to screen space. Bitmap fonts are
+ * stretched; SDF fonts are re-thresholded per pixel and stay sharp. */
+void ocfx_text_draw_scaled(ocfx_renderer_t *renderer, ocfx_font_t *font,
+                           const char *text, float x, float y, float scale,
+                           ocfx_color_t color);
+void ocfx_text_draw_transformed(ocfx_renderer_t *renderer, ocfx_font_t *font,
+                                const char *text, ocfx_transform_t transform,
+                                ocfx_color_t color);
+
+/* Rich text: styled byte ranges of one string. Spans are sorted by start
+ * and do not overlap; bytes outside every span use the base font and
+ * color. A NULL font means the base font. Fonts must share the base
+ * font's renderer. */
+typedef struct {
+    size_t start;
+    size_t len;
+    ocfx_font_t *font;
+    ocfx_color_t color;
+    ocfx_color_t background;      /* Alpha 0 = none */
+} ocfx_text_span_t;
+
+/* Draw text[0, len) with its spans in one pass on a shared baseline (the
+ * base font's, with (x, y) its top-left). Backgrounds cover the base
+ * font's line height and go into the same batch as the glyphs, so a
+ * line of mixed colors costs one draw call per atlas page, not per span. */
+void ocfx_text_draw_spans(ocfx_renderer_t *renderer, ocfx_font_t *font,
+                          const char *text, size_t len,
+                          const ocfx_text_span_t *spans, size_t span_count,
+                          float x, float y, ocfx_color_t color);
+
+/* Numbers, drawn from cached digit quads without formatting or decoding
+ * (for counters and readouts redrawn every frame). Digits sit centered in
+ * tabular cells, so a changing value does not jitter: decimal digits are
+ * ocfx_font_get_digit_width wide, hex digits as wide as the widest of
+ * 0-9 and a-f. Values draw at (x, y), the top-left of the text; each
+ * call returns the width drawn. Fixed-point takes 0 to 9 decimals. */
+float ocfx_text_draw_int(ocfx_renderer_t *renderer, ocfx_font_t *font, int64_t value,
+                         float x, float y, ocfx_color_t color);
+float ocfx_text_draw_fixed(ocfx_renderer_t *renderer, ocfx_font_t *font, double value,
+                           int decimals, float x, float y, ocfx_color_t color);
+float ocfx_text_draw_hex(ocfx_renderer_t *renderer, ocfx_font_t *font, uint64_t value,
+                         int min_digits, float x, float y, ocfx_color_t color);
+float ocfx_font_get_digit_width(ocfx_font_t *font);
+
+/* Prepared text runs. A run decodes and lays out a string once; drawing
+ * it copies the finished quads into the batch at a new position and
+ * color. Runs re-layout themselves if the atlas evicts their glyphs, and
+ * must be destroyed before their font. */
+typedef struct ocfx_text_run_t ocfx_text_run_t;
+
+ocfx_text_run_t* ocfx_text_run_create(ocfx_font_t *font, const char *text, size_t len);
+void ocfx_text_run_destroy(ocfx_text_run_t *run);
+void ocfx_text_run_measure(ocfx_text_run_t *run, float *width, float *height);
+void ocfx_text_run_draw(ocfx_renderer_t *renderer, ocfx_text_run_t *run,
+                        float x, float y, ocfx_color_t color);
+
+/* Keep up to max_runs (0 = off, the default) runs per font for strings
+ * drawn repeatedly with ocfx_text_draw/_n, keyed by string hash. A string
+ * is cached on its second draw, provided its set still remembers the
+ * first: each set keeps the hashes of its last few strings drawn once,
+ * so text that changes every frame does not evict cached runs. */
+void ocfx_font_set_run_cache(ocfx_font_t *font, size_t max_runs);
+
 /* Advanced text rendering */
 typedef enum {
     OCFX_TEXT_ALIGN_LEFT,
@@ -47,18 +205,52 @@ typedef enum {
     OCFX_TEXT_BASELINE_ALPHABETIC,
 } ocfx_text_baseline_t;
 
+/* Single line placed in rect. Baselines: TOP puts the ascent at rect.y,
+ * MIDDLE and BOTTOM center or bottom-align the ascent-to-descent box,
+ * ALPHABETIC puts the baseline on rect.y. Center and right alignment lay
+ * the string out once and shift the finished quads, so they cost about
+ * the same as left-aligned text. */
 void ocfx_text_draw_aligned(ocfx_renderer_t *renderer, ocfx_font_t *font,
                             const char *text, ocfx_rect_t rect,
                             ocfx_text_align_t align, ocfx_text_baseline_t baseline,
                             ocfx_color_t color);
 
-/* Multi-line text */
+/* Multi-line text. Lines break at spaces and newlines to fit rect.width
+ * (words wider than that are split) and advance by line_spacing times the
+ * font height (<= 0 means 1). Lines below the rect are not laid out.
+ * Recently wrapped strings keep their line breaks per paragraph, so a
+ * width change only re-breaks paragraphs whose breaks actually move. */
 void ocfx_text_draw_wrapped(ocfx_renderer_t *renderer, ocfx_font_t *font,
                             const char *text, ocfx_rect_t rect, float line_spacing,
                             ocfx_color_t color);
 
+/* Explicit layout for large documents: text is a view that must outlive
+ * the layout (and the layout its font). Paragraphs are wrapped lazily, on
+ * first draw or query; visible selects the lines that get drawn. */
+typedef struct ocfx_text_layout_t ocfx_text_layout_t;
+
+typedef enum {
+    OCFX_WRAP_GREEDY,             /* First fit (default) */
+    OCFX_WRAP_BALANCED,           /* Minimum raggedness, evens out line lengths */
+} ocfx_wrap_mode_t;
+
+ocfx_text_layout_t* ocfx_text_layout_create(ocfx_font_t *font, const char *text, size_t len);
+void ocfx_text_layout_destroy(ocfx_text_layout_t *layout);
+void ocfx_text_layout_set_width(ocfx_text_layout_t *layout, float width);  /* <= 0: no wrap */
+void ocfx_text_layout_set_mode(ocfx_text_layout_t *layout, ocfx_wrap_mode_t mode);
+size_t ocfx_text_layout_line_count(ocfx_text_layout_t *layout);
+void ocfx_text_layout_draw(ocfx_renderer_t *renderer, ocfx_text_layout_t *layout,
+                           float x, float y, float line_spacing, ocfx_rect_t visible,
+                           ocfx_color_t color);
+
 /* UTF-8 support */
 bool ocfx_text_is_valid_utf8(const char *text, size_t len);
 size_t ocfx_text_utf8_char_count(const char *text);
 
+/* Bulk decode of up to max codepoints from text[0, len). Stops early at a
+ * NUL or a malformed sequence; *consumed (optional) receives the number of
+ * bytes used. Returns the number of codepoints written. */
+size_t ocfx_text_utf8_decode(const char *text, size_t len, uint32_t *codepoints, size_t max,
+                             size_t *consumed);
+
 #endif /* OCFX_TEXT_H */
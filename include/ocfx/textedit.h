@@ -0,0 +1,50 @@
+/* OCFX - Editable Text Interface
+ * Piece-table text buffer with per-line layout caches for editors
+ */
+
+#ifndef OCFX_TEXTEDIT_H
+#define OCFX_TEXTEDIT_H
+
+#include "types.h"
+#include "render.h"
+#include "text.h"
+
+/* Forward declaration */
+typedef struct ocfx_text_buffer_t ocfx_text_buffer_t;
+
+/* Editable document. Edits only touch the piece table, the line index
+ * and the cached layout of the lines they change, so a keystroke costs
+ * about the same in a 100k-line file as in a short one. Offsets are byte
+ * offsets and must fall on UTF-8 boundaries. Lines end at '\n'. The
+ * buffer must be destroyed before its font. */
+ocfx_text_buffer_t* ocfx_text_buffer_create(ocfx_font_t *font, const char *text, size_t len);
+void ocfx_text_buffer_destroy(ocfx_text_buffer_t *buffer);
+
+bool ocfx_text_buffer_insert(ocfx_text_buffer_t *buffer, size_t offset,
+                             const char *text, size_t len);
+bool ocfx_text_buffer_delete(ocfx_text_buffer_t *buffer, size_t offset, size_t len);
+
+/* Contents */
+size_t ocfx_text_buffer_length(ocfx_text_buffer_t *buffer);
+size_t ocfx_text_buffer_line_count(ocfx_text_buffer_t *buffer);
+size_t ocfx_text_buffer_line_start(ocfx_text_buffer_t *buffer, size_t line);
+size_t ocfx_text_buffer_line_of(ocfx_text_buffer_t *buffer, size_t offset);
+
+/* Copy up to len bytes from offset into out; returns the bytes copied */
+size_t ocfx_text_buffer_read(ocfx_text_buffer_t *buffer, size_t offset, size_t len, char *out);
+
+/* Lines advance by line_spacing times the font height (<= 0 means 1) */
+void ocfx_text_buffer_set_line_spacing(ocfx_text_buffer_t *buffer, float line_spacing);
+
+/* Caret geometry, relative to the document origin. ocfx_text_buffer_caret
+ * gives the top-left of the caret before offset; hit testing returns the
+ * offset of the caret nearest to (x, y). */
+void ocfx_text_buffer_caret(ocfx_text_buffer_t *buffer, size_t offset, float *x, float *y);
+size_t ocfx_text_buffer_hit_test(ocfx_text_buffer_t *buffer, float x, float y);
+
+/* Draw with the document origin at (x, y); only lines intersecting
+ * visible are laid out and drawn */
+void ocfx_text_buffer_draw(ocfx_renderer_t *renderer, ocfx_text_buffer_t *buffer,
+                           float x, float y, ocfx_rect_t visible, ocfx_color_t color);
+
+#endif /* OCFX_TEXTEDIT_H */
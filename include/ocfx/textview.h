@@ -0,0 +1,42 @@
+/* OCFX - Text View Interface
+ * Scrollable view over very large line-oriented buffers (logs, dumps)
+ */
+
+#ifndef OCFX_TEXTVIEW_H
+#define OCFX_TEXTVIEW_H
+
+#include "types.h"
+#include "render.h"
+#include "text.h"
+
+/* Forward declaration */
+typedef struct ocfx_text_view_t ocfx_text_view_t;
+
+/* A view indexes line starts in the background (large buffers) or right
+ * away (small ones) and only ever touches the lines it draws, so
+ * scrolling and drawing cost the same at line 10 as at line 10 million.
+ * The index takes 8 bytes per line. Lines end at '\n' ("\r\n" too) and
+ * are not wrapped. */
+ocfx_text_view_t* ocfx_text_view_create(ocfx_font_t *font, const char *text, size_t len);
+ocfx_text_view_t* ocfx_text_view_open(ocfx_font_t *font, const char *path);
+void ocfx_text_view_destroy(ocfx_text_view_t *view);
+
+/* Lines indexed so far; *complete (optional) tells whether indexing has
+ * reached the end of the buffer. ocfx_text_view_wait blocks until it has. */
+size_t ocfx_text_view_line_count(ocfx_text_view_t *view, bool *complete);
+void ocfx_text_view_wait(ocfx_text_view_t *view);
+
+/* Bytes of an indexed line (without the line break), or NULL */
+const char* ocfx_text_view_get_line(ocfx_text_view_t *view, size_t line, size_t *len);
+
+/* First line drawn. Lines past the indexed range clamp to its end. */
+void ocfx_text_view_scroll_to(ocfx_text_view_t *view, size_t line);
+size_t ocfx_text_view_get_top(ocfx_text_view_t *view);
+
+/* Draw the lines from the top line on that start inside rect, advancing
+ * by line_spacing times the font height (<= 0 means 1). Glyphs starting
+ * right of the rect are left out, so long lines cost only what shows. */
+void ocfx_text_view_draw(ocfx_renderer_t *renderer, ocfx_text_view_t *view,
+                         ocfx_rect_t rect, float line_spacing, ocfx_color_t color);
+
+#endif /* OCFX_TEXTVIEW_H */
@@ -40,6 +40,12 @@ typedef struct {
     float width, height;
 } ocfx_rect_t;
 
+/* 2D affine transform: x' = a*x + c*y + tx, y' = b*x + d*y + ty */
+typedef struct {
+    float a, b, c, d;
+    float tx, ty;
+} ocfx_transform_t;
+
 /* Predefined colors */
 extern const ocfx_color_t OCFX_COLOR_BLACK;
 extern const ocfx_color_t OCFX_COLOR_WHITE;
@@ -54,5 +60,7 @@ extern const ocfx_color_t OCFX_COLOR_TRANSPARENT;
 #define OCFX_RECT(x, y, w, h) ((ocfx_rect_t){x, y, w, h})
 #define OCFX_POINT(x, y) ((ocfx_point_t){x, y})
 #define OCFX_SIZE(w, h) ((ocfx_size_t){w, h})
+#define OCFX_TRANSFORM_IDENTITY ((ocfx_transform_t){1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f})
+#define OCFX_TRANSFORM_SCALE(s, x, y) ((ocfx_transform_t){s, 0.0f, 0.0f, s, x, y})
 
 #endif /* OCFX_TYPES_H */
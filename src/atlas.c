@@ -0,0 +1,972 @@
+/* OCFX - Glyph Atlas Implementation
+ * Skyline packed, LRU evicted texture pages shared by every font of a
+ * renderer, plus the quad batch that draws from them
+ */
+
+#include "atlas.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <GLES3/gl3.h>
+
+#define OCFX_ATLAS_PADDING 1          /* Gap between glyphs (avoids filter bleed) */
+#define OCFX_ATLAS_SOLID 4            /* Opaque block at (0, 0) of every page */
+
+/* Skyline segment: the packed area's top edge is y over [x, x + width) */
+typedef struct {
+    int x, y, width;
+} skyline_node_t;
+
+/* Atlas page (one R8 texture, skyline packed). texture == 0 marks a
+ * free slot left behind by eviction. New glyphs are written to a CPU
+ * shadow of the page and reach the texture as one dirty rectangle when
+ * the page is next drawn. */
+typedef struct {
+    GLuint texture;
+    int width;
+    int height;
+    uint8_t *pixels;              /* Shadow copy, width * height */
+    int dirty_x0, dirty_y0;       /* Pending upload (empty when x0 >= x1) */
+    int dirty_x1, dirty_y1;
+    skyline_node_t *skyline;
+    int node_count;
+    int node_capacity;
+    uint64_t last_used;           /* Newest last_used of any glyph on the page */
+} atlas_page_t;
+
+/* Strike: glyphs of one face at one size and render mode */
+typedef struct {
+    uint32_t face_id;
+    int size;
+    uint32_t mode;
+    uint32_t flags;               /* OCFX_STRIKE_* */
+    uint32_t refs;                /* 0 = free slot */
+    uint32_t block_page;          /* Page of the uploaded strike image + 1, 0 = none */
+} atlas_strike_t;
+
+/* Atlas structure (renderer-wide) */
+struct ocfx_atlas_t {
+    ocfx_renderer_t *renderer;
+
+    /* Texture pages (pages double in size, then more pages are added,
+     * up to limit bytes) */
+    atlas_page_t *pages;
+    size_t page_count;
+    size_t page_capacity;
+    size_t newest_page;
+    int max_size;
+    size_t bytes;
+    size_t limit;
+
+    /* Per-frame glyph work budget (0 = unlimited) */
+    size_t budget_bytes;
+    uint64_t budget_ns;
+    size_t spent_bytes;
+    uint64_t spent_ns;
+    uint64_t budget_frame;
+
+    /* Glyph cache */
+    ocfx_glyph_t *glyphs;
+    size_t glyph_count;
+    size_t glyph_capacity;
+    uint32_t generation;          /* Bumped whenever glyphs are dropped */
+
+    /* Glyph index (open addressing, stores cache index + 1, 0 = empty) */
+    uint32_t *index;
+    size_t index_capacity;
+
+    /* Strikes (id = slot + 1) */
+    atlas_strike_t *strikes;
+    size_t strike_count;
+
+    /* Quad batch (one shader program per render mode) */
+    GLuint programs[OCFX_ATLAS_MODE_COUNT];
+    GLint u_resolution[OCFX_ATLAS_MODE_COUNT];
+    GLint u_texture[OCFX_ATLAS_MODE_COUNT];
+    GLuint vao;
+    GLuint vbo;
+    GLuint ebo;
+    ocfx_text_vertex_t *vertices;
+    size_t quad_count;
+    uint32_t batch_page;
+    uint32_t batch_mode;
+};
+
+/* Text vertex shader */
+static const char *text_vertex_shader =
+    "#version 300 es\n"
+    "precision highp float;\n"
+    "layout(location = 0) in vec2 a_position;\n"
+    "layout(location = 1) in vec2 a_texcoord;\n"
+    "layout(location = 2) in vec4 a_color;\n"
+    "out vec2 v_texcoord;\n"
+    "out vec4 v_color;\n"
+    "uniform vec2 u_resolution;\n"
+    "uniform sampler2D u_texture;\n"
+    "void main() {\n"
+    "    vec2 clip_pos = (a_position / u_resolution) * 2.0 - 1.0;\n"
+    "    clip_pos.y = -clip_pos.y;\n"
+    "    gl_Position = vec4(clip_pos, 0.0, 1.0);\n"
+    "    v_texcoord = a_texcoord / vec2(textureSize(u_texture, 0));\n"
+    "    v_color = a_color;\n"
+    "}\n";
+
+/* Text fragment shader */
+static const char *text_fragment_shader =
+    "#version 300 es\n"
+    "precision highp float;\n"
+    "in vec2 v_texcoord;\n"
+    "in vec4 v_color;\n"
+    "out vec4 fragColor;\n"
+    "uniform sampler2D u_texture;\n"
+    "void main() {\n"
+    "    float alpha = texture(u_texture, v_texcoord).r;\n"
+    "    fragColor = vec4(v_color.rgb, v_color.a * alpha);\n"
+    "}\n";
+
+/* Signed distance field fragment shader: the field is 0.5 on the outline
+ * and grows inwards; the smoothing width follows the screen-space rate of
+ * change, so edges stay one pixel soft at any scale or rotation */
+static const char *sdf_fragment_shader =
+    "#version 300 es\n"
+    "precision highp float;\n"
+    "in vec2 v_texcoord;\n"
+    "in vec4 v_color;\n"
+    "out vec4 fragColor;\n"
+    "uniform sampler2D u_texture;\n"
+    "void main() {\n"
+    "    float dist = texture(u_texture, v_texcoord).r;\n"
+    "    float width = max(fwidth(dist) * 0.7, 1e-4);\n"
+    "    float alpha = smoothstep(0.5 - width, 0.5 + width, dist);\n"
+    "    fragColor = vec4(v_color.rgb, v_color.a * alpha);\n"
+    "}\n";
+
+/* Compile shader (copied from render.c pattern) */
+static GLuint compile_text_shader(GLenum type, const char *source) {
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+
+    GLint success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        char info_log[512];
+        glGetShaderInfoLog(shader, sizeof(info_log), NULL, info_log);
+        fprintf(stderr, "OCFX: Text shader compilation failed: %s\n", info_log);
+        return 0;
+    }
+    return shader;
+}
+
+/* Create text shader program */
+static GLuint create_text_shader_program(const char *frag_src) {
+    GLuint vert = compile_text_shader(GL_VERTEX_SHADER, text_vertex_shader);
+    GLuint frag = compile_text_shader(GL_FRAGMENT_SHADER, frag_src);
+
+    if (!vert || !frag) return 0;
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vert);
+    glAttachShader(program, frag);
+    glLinkProgram(program);
+
+    GLint success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        char info_log[512];
+        glGetProgramInfoLog(program, sizeof(info_log), NULL, info_log);
+        fprintf(stderr, "OCFX: Text shader linking failed: %s\n", info_log);
+        return 0;
+    }
+
+    glDeleteShader(vert);
+    glDeleteShader(frag);
+
+    return program;
+}
+
+/* ============================================================================
+ * Glyph index
+ * ============================================================================ */
+
+/* Hash a glyph key into the index */
+static inline size_t glyph_hash(uint64_t key, size_t capacity) {
+    key ^= key >> 29;
+    key *= 0xbf58476d1ce4e5b9ull;
+    key ^= key >> 32;
+    return (size_t)key & (capacity - 1);
+}
+
+/* Rebuild the glyph index from the cache array (capacity is a power of two) */
+static bool rebuild_index(ocfx_atlas_t *atlas, size_t capacity) {
+    if (capacity != atlas->index_capacity) {
+        uint32_t *index = realloc(atlas->index, capacity * sizeof(uint32_t));
+        if (!index) return false;
+        atlas->index = index;
+        atlas->index_capacity = capacity;
+    }
+    memset(atlas->index, 0, capacity * sizeof(uint32_t));
+
+    for (size_t i = 0; i < atlas->glyph_count; i++) {
+        size_t slot = glyph_hash(atlas->glyphs[i].key, capacity);
+        while (atlas->index[slot]) {
+            slot = (slot + 1) & (capacity - 1);
+        }
+        atlas->index[slot] = (uint32_t)(i + 1);
+    }
+    return true;
+}
+
+/* Drop glyphs matching a page or a strike, compacting the cache */
+static void drop_glyphs(ocfx_atlas_t *atlas, bool by_page, uint32_t value) {
+    size_t kept = 0;
+    for (size_t i = 0; i < atlas->glyph_count; i++) {
+        ocfx_glyph_t *glyph = &atlas->glyphs[i];
+        uint32_t match = by_page ? glyph->page : (uint32_t)(glyph->key >> 32);
+        if (match != value) {
+            atlas->glyphs[kept++] = *glyph;
+        }
+    }
+    if (kept != atlas->glyph_count) {
+        atlas->glyph_count = kept;
+        atlas->generation++;
+        rebuild_index(atlas, atlas->index_capacity);
+    }
+}
+
+/* ============================================================================
+ * Skyline packer
+ * ============================================================================ */
+
+/* Lowest y at which a width x height rect fits with its left edge at
+ * skyline node i, or -1 if it does not fit */
+static int skyline_fit(const atlas_page_t *page, int i, int width, int height) {
+    int x = page->skyline[i].x;
+    if (x + width > page->width) return -1;
+
+    int y = 0;
+    int remaining = width;
+    while (remaining > 0) {
+        if (page->skyline[i].y > y) y = page->skyline[i].y;
+        if (y + height > page->height) return -1;
+        remaining -= page->skyline[i].width;
+        i++;
+    }
+    return y;
+}
+
+/* Insert a skyline node at index i */
+static bool skyline_insert(atlas_page_t *page, int i, int x, int y, int width) {
+    if (page->node_count >= page->node_capacity) {
+        int new_cap = page->node_capacity ? page->node_capacity * 2 : 32;
+        skyline_node_t *nodes = realloc(page->skyline, new_cap * sizeof(skyline_node_t));
+        if (!nodes) return false;
+        page->skyline = nodes;
+        page->node_capacity = new_cap;
+    }
+
+    memmove(&page->skyline[i + 1], &page->skyline[i],
+            (page->node_count - i) * sizeof(skyline_node_t));
+    page->skyline[i] = (skyline_node_t){x, y, width};
+    page->node_count++;
+    return true;
+}
+
+static void skyline_remove(atlas_page_t *page, int i) {
+    memmove(&page->skyline[i], &page->skyline[i + 1],
+            (page->node_count - i - 1) * sizeof(skyline_node_t));
+    page->node_count--;
+}
+
+/* Merge neighbouring segments of equal height */
+static void skyline_merge(atlas_page_t *page) {
+    for (int i = 0; i < page->node_count - 1; i++) {
+        if (page->skyline[i].y == page->skyline[i + 1].y) {
+            page->skyline[i].width += page->skyline[i + 1].width;
+            skyline_remove(page, i + 1);
+            i--;
+        }
+    }
+}
+
+/* Bottom-left skyline packing: place the rect where its top edge ends up
+ * lowest, preferring the narrowest segment on ties */
+static bool skyline_pack(atlas_page_t *page, int width, int height, int *out_x, int *out_y) {
+    int best_top = page->height + 1;
+    int best_width = page->width + 1;
+    int best_i = -1, best_x = 0, best_y = 0;
+
+    for (int i = 0; i < page->node_count; i++) {
+        int y = skyline_fit(page, i, width, height);
+        if (y < 0) continue;
+        if (y + height < best_top ||
+            (y + height == best_top && page->skyline[i].width < best_width)) {
+            best_top = y + height;
+            best_width = page->skyline[i].width;
+            best_i = i;
+            best_x = page->skyline[i].x;
+            best_y = y;
+        }
+    }
+    if (best_i < 0) return false;
+
+    if (!skyline_insert(page, best_i, best_x, best_y + height, width)) return false;
+
+    /* Trim the segments now covered by the new one */
+    for (int i = best_i + 1; i < page->node_count; i++) {
+        int prev_end = page->skyline[i - 1].x + page->skyline[i - 1].width;
+        if (page->skyline[i].x >= prev_end) break;
+
+        int shrink = prev_end - page->skyline[i].x;
+        page->skyline[i].x += shrink;
+        page->skyline[i].width -= shrink;
+        if (page->skyline[i].width > 0) break;
+        skyline_remove(page, i);
+        i--;
+    }
+    skyline_merge(page);
+
+    *out_x = best_x;
+    *out_y = best_y;
+    return true;
+}
+
+/* Reset a page's skyline to a single empty segment */
+static void skyline_reset(atlas_page_t *page) {
+    page->node_count = 0;
+    skyline_insert(page, 0, 0, 0, page->width);
+}
+
+/* ============================================================================
+ * Pages
+ * ============================================================================ */
+
+/* Allocate an R8 texture for an atlas page */
+static GLuint create_page_texture(int width, int height) {
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0,
+                 GL_RED, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    return texture;
+}
+
+/* Upload a page's dirty rectangle from its shadow copy */
+static void sync_page(atlas_page_t *page) {
+    if (page->dirty_x0 >= page->dirty_x1) return;
+
+    int x = page->dirty_x0, y = page->dirty_y0;
+    glBindTexture(GL_TEXTURE_2D, page->texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, page->width);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, page->dirty_x1 - x, page->dirty_y1 - y,
+                    GL_RED, GL_UNSIGNED_BYTE, page->pixels + (size_t)y * page->width + x);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+    page->dirty_x0 = page->dirty_y0 = page->dirty_x1 = page->dirty_y1 = 0;
+}
+
+static void mark_dirty(atlas_page_t *page, int x0, int y0, int x1, int y1) {
+    if (x1 > page->width) x1 = page->width;
+    if (y1 > page->height) y1 = page->height;
+    if (page->dirty_x0 >= page->dirty_x1) {
+        page->dirty_x0 = x0;
+        page->dirty_y0 = y0;
+        page->dirty_x1 = x1;
+        page->dirty_y1 = y1;
+        return;
+    }
+    if (x0 < page->dirty_x0) page->dirty_x0 = x0;
+    if (y0 < page->dirty_y0) page->dirty_y0 = y0;
+    if (x1 > page->dirty_x1) page->dirty_x1 = x1;
+    if (y1 > page->dirty_y1) page->dirty_y1 = y1;
+}
+
+/* Create a new, empty page at the initial size (reusing a slot freed by
+ * eviction if there is one) */
+static atlas_page_t* add_page(ocfx_atlas_t *atlas) {
+    size_t slot = 0;
+    while (slot < atlas->page_count && atlas->pages[slot].texture) {
+        slot++;
+    }
+
+    if (slot == atlas->page_count) {
+        if (atlas->page_count >= atlas->page_capacity) {
+            size_t new_cap = atlas->page_capacity ? atlas->page_capacity * 2 : 4;
+            atlas_page_t *pages = realloc(atlas->pages, new_cap * sizeof(atlas_page_t));
+            if (!pages) return NULL;
+            atlas->pages = pages;
+            atlas->page_capacity = new_cap;
+        }
+        memset(&atlas->pages[slot], 0, sizeof(atlas_page_t));
+        atlas->page_count++;
+    }
+
+    atlas_page_t *page = &atlas->pages[slot];
+    int size = OCFX_ATLAS_INITIAL_SIZE < atlas->max_size ?
+               OCFX_ATLAS_INITIAL_SIZE : atlas->max_size;
+    page->pixels = calloc((size_t)size * size, 1);
+    if (!page->pixels) return NULL;
+    page->width = size;
+    page->height = size;
+    skyline_reset(page);
+    page->texture = create_page_texture(size, size);
+
+    /* Solid block for untextured quads (see ocfx_atlas_push_rect); it
+     * packs first, so it lands at the origin */
+    int solid_x, solid_y;
+    skyline_pack(page, OCFX_ATLAS_SOLID + OCFX_ATLAS_PADDING,
+                 OCFX_ATLAS_SOLID + OCFX_ATLAS_PADDING, &solid_x, &solid_y);
+    for (int row = 0; row < OCFX_ATLAS_SOLID; row++) {
+        memset(page->pixels + (size_t)row * size, 0xFF, OCFX_ATLAS_SOLID);
+    }
+
+    /* Texture contents start undefined: clear it through the shadow */
+    mark_dirty(page, 0, 0, size, size);
+    page->last_used = ocfx_render_get_frame(atlas->renderer);
+
+    atlas->bytes += (size_t)size * size;
+    atlas->newest_page = slot;
+    return page;
+}
+
+/* Double a page in both directions. The old contents are copied into the
+ * larger shadow, so glyph positions stay valid (texture coordinates are in
+ * pixels and normalized in the shader), and the whole new texture is
+ * uploaded from it when the page is next drawn. The three new quadrants
+ * are 3/4 of that upload anyway, so copying the old quarter on the GPU
+ * would save little and cost a framebuffer bind mid-frame. */
+static bool grow_page(ocfx_atlas_t *atlas, atlas_page_t *page) {
+    int old_width = page->width;
+    int old_height = page->height;
+
+    uint8_t *pixels = calloc((size_t)old_width * old_height * 4, 1);
+    if (!pixels) return false;
+    for (int row = 0; row < old_height; row++) {
+        memcpy(pixels + (size_t)row * old_width * 2, page->pixels + (size_t)row * old_width,
+               (size_t)old_width);
+    }
+
+    GLuint texture = create_page_texture(old_width * 2, old_height * 2);
+    glDeleteTextures(1, &page->texture);
+    free(page->pixels);
+    page->texture = texture;
+    page->pixels = pixels;
+    page->width = old_width * 2;
+    page->height = old_height * 2;
+
+    mark_dirty(page, 0, 0, page->width, page->height);
+    atlas->bytes += (size_t)page->width * page->height -
+                    (size_t)old_width * old_height;
+
+    /* The new right half is empty; extra height needs no new segment */
+    if (!skyline_insert(page, page->node_count, old_width, 0, old_width)) return false;
+    skyline_merge(page);
+    return true;
+}
+
+/* Free the least recently used page other than the newest one: drop every
+ * glyph it holds and release its texture. Pending quads are flushed first,
+ * so even a page used earlier in the frame can go. */
+static void evict_page(ocfx_atlas_t *atlas) {
+    size_t victim = atlas->newest_page;
+    for (size_t i = 0; i < atlas->page_count; i++) {
+        if (!atlas->pages[i].texture || i == atlas->newest_page) continue;
+        if (victim == atlas->newest_page ||
+            atlas->pages[i].last_used < atlas->pages[victim].last_used) {
+            victim = i;
+        }
+    }
+
+    if (atlas->quad_count && atlas->batch_page == victim) {
+        ocfx_atlas_flush(atlas);
+    }
+    drop_glyphs(atlas, true, (uint32_t)victim);
+    for (size_t i = 0; i < atlas->strike_count; i++) {
+        if (atlas->strikes[i].block_page == victim + 1) atlas->strikes[i].block_page = 0;
+    }
+
+    atlas_page_t *page = &atlas->pages[victim];
+    glDeleteTextures(1, &page->texture);
+    free(page->pixels);
+    page->pixels = NULL;
+    page->texture = 0;
+    atlas->bytes -= (size_t)page->width * page->height;
+}
+
+/* Count pages currently holding a texture */
+static size_t live_page_count(const ocfx_atlas_t *atlas) {
+    size_t count = 0;
+    for (size_t i = 0; i < atlas->page_count; i++) {
+        if (atlas->pages[i].texture) count++;
+    }
+    return count;
+}
+
+/* Reserve space for a width x height bitmap. Tries the existing pages
+ * first, then grows the newest page, then adds a page while under the
+ * memory cap, and evicts as a last resort. A lone page may always grow
+ * so that any glyph up to the maximum page size can be placed. */
+static atlas_page_t* atlas_alloc(ocfx_atlas_t *atlas, int width, int height,
+                                 int *out_x, int *out_y) {
+    int w = width + OCFX_ATLAS_PADDING;
+    int h = height + OCFX_ATLAS_PADDING;
+    if (w > atlas->max_size || h > atlas->max_size) {
+        fprintf(stderr, "OCFX: Glyph %dx%d larger than atlas page\n", width, height);
+        return NULL;
+    }
+
+    for (;;) {
+        for (size_t i = atlas->page_count; i-- > 0;) {
+            atlas_page_t *page = &atlas->pages[i];
+            if (page->texture && skyline_pack(page, w, h, out_x, out_y)) {
+                return page;
+            }
+        }
+
+        size_t live = live_page_count(atlas);
+        if (live > 0) {
+            atlas_page_t *newest = &atlas->pages[atlas->newest_page];
+            size_t growth = (size_t)newest->width * newest->height * 3;
+            if (newest->width < atlas->max_size &&
+                (live == 1 || atlas->bytes + growth <= atlas->limit)) {
+                if (!grow_page(atlas, newest)) return NULL;
+                continue;
+            }
+        }
+
+        size_t page_bytes = (size_t)OCFX_ATLAS_INITIAL_SIZE * OCFX_ATLAS_INITIAL_SIZE;
+        if (live == 0 || atlas->bytes + page_bytes <= atlas->limit) {
+            if (!add_page(atlas)) return NULL;
+            continue;
+        }
+
+        if (live == 1) {
+            /* The only page is full at maximum size: start over */
+            atlas->newest_page = atlas->page_count;
+        }
+        evict_page(atlas);
+    }
+}
+
+/* ============================================================================
+ * Internal API
+ * ============================================================================ */
+
+ocfx_atlas_t* ocfx_atlas_create(ocfx_renderer_t *renderer) {
+    ocfx_atlas_t *atlas = calloc(1, sizeof(ocfx_atlas_t));
+    if (!atlas) return NULL;
+
+    atlas->renderer = renderer;
+    atlas->limit = OCFX_ATLAS_MAX_BYTES;
+
+    GLint max_texture_size = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_texture_size);
+    atlas->max_size = OCFX_ATLAS_PAGE_SIZE;
+    if (max_texture_size > 0 && max_texture_size < atlas->max_size) {
+        atlas->max_size = max_texture_size;
+    }
+
+    const char *fragment_shaders[OCFX_ATLAS_MODE_COUNT] = {
+        [OCFX_ATLAS_MODE_BITMAP] = text_fragment_shader,
+        [OCFX_ATLAS_MODE_SDF] = sdf_fragment_shader,
+    };
+    for (int mode = 0; mode < OCFX_ATLAS_MODE_COUNT; mode++) {
+        GLuint program = create_text_shader_program(fragment_shaders[mode]);
+        if (!program) {
+            ocfx_atlas_destroy(atlas);
+            return NULL;
+        }
+        atlas->programs[mode] = program;
+        atlas->u_resolution[mode] = glGetUniformLocation(program, "u_resolution");
+        atlas->u_texture[mode] = glGetUniformLocation(program, "u_texture");
+    }
+
+    atlas->vertices = malloc(OCFX_TEXT_BATCH_QUADS * 4 * sizeof(ocfx_text_vertex_t));
+    if (!atlas->vertices) {
+        ocfx_atlas_destroy(atlas);
+        return NULL;
+    }
+
+    /* Static index buffer: two triangles per quad */
+    uint16_t *indices = malloc(OCFX_TEXT_BATCH_QUADS * 6 * sizeof(uint16_t));
+    if (!indices) {
+        ocfx_atlas_destroy(atlas);
+        return NULL;
+    }
+    for (uint16_t q = 0; q < OCFX_TEXT_BATCH_QUADS; q++) {
+        uint16_t v = (uint16_t)(q * 4);
+        uint16_t *i = &indices[q * 6];
+        i[0] = v; i[1] = v + 1; i[2] = v + 2;
+        i[3] = v + 1; i[4] = v + 3; i[5] = v + 2;
+    }
+
+    /* VAO keeps the vertex layout and index buffer */
+    glGenVertexArrays(1, &atlas->vao);
+    glGenBuffers(1, &atlas->vbo);
+    glGenBuffers(1, &atlas->ebo);
+
+    glBindVertexArray(atlas->vao);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, atlas->ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, OCFX_TEXT_BATCH_QUADS * 6 * sizeof(uint16_t),
+                 indices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, atlas->vbo);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(ocfx_text_vertex_t),
+                          (void*)offsetof(ocfx_text_vertex_t, x));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(ocfx_text_vertex_t),
+                          (void*)offsetof(ocfx_text_vertex_t, u));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ocfx_text_vertex_t),
+                          (void*)offsetof(ocfx_text_vertex_t, r));
+    glEnableVertexAttribArray(2);
+    glBindVertexArray(0);
+
+    free(indices);
+    return atlas;
+}
+
+void ocfx_atlas_destroy(ocfx_atlas_t *atlas) {
+    if (!atlas) return;
+
+    for (size_t i = 0; i < atlas->page_count; i++) {
+        if (atlas->pages[i].texture) glDeleteTextures(1, &atlas->pages[i].texture);
+        free(atlas->pages[i].pixels);
+        free(atlas->pages[i].skyline);
+    }
+    free(atlas->pages);
+
+    if (atlas->ebo) glDeleteBuffers(1, &atlas->ebo);
+    if (atlas->vbo) glDeleteBuffers(1, &atlas->vbo);
+    if (atlas->vao) glDeleteVertexArrays(1, &atlas->vao);
+    for (int mode = 0; mode < OCFX_ATLAS_MODE_COUNT; mode++) {
+        if (atlas->programs[mode]) glDeleteProgram(atlas->programs[mode]);
+    }
+
+    free(atlas->vertices);
+    free(atlas->glyphs);
+    free(atlas->index);
+    free(atlas->strikes);
+    free(atlas);
+}
+
+void ocfx_atlas_set_limit(ocfx_atlas_t *atlas, size_t max_bytes) {
+    if (!atlas) return;
+
+    /* A single page may always grow to the maximum size regardless */
+    atlas->limit = max_bytes;
+}
+
+uint32_t ocfx_atlas_acquire_strike(ocfx_atlas_t *atlas, uint32_t face_id,
+                                   int size, uint32_t mode, uint32_t flags) {
+    size_t free_slot = atlas->strike_count;
+    for (size_t i = 0; i < atlas->strike_count; i++) {
+        atlas_strike_t *strike = &atlas->strikes[i];
+        if (!strike->refs) {
+            if (free_slot == atlas->strike_count) free_slot = i;
+            continue;
+        }
+        if (strike->face_id == face_id && strike->size == size && strike->mode == mode &&
+            strike->flags == flags) {
+            strike->refs++;
+            return (uint32_t)(i + 1);
+        }
+    }
+
+    if (free_slot == atlas->strike_count) {
+        atlas_strike_t *strikes = realloc(atlas->strikes,
+                                          (atlas->strike_count + 1) * sizeof(atlas_strike_t));
+        if (!strikes) return 0;
+        atlas->strikes = strikes;
+        atlas->strike_count++;
+    }
+
+    atlas->strikes[free_slot] = (atlas_strike_t){face_id, size, mode, flags, 1, 0};
+    return (uint32_t)(free_slot + 1);
+}
+
+void ocfx_atlas_release_strike(ocfx_atlas_t *atlas, uint32_t strike) {
+    if (!atlas || strike == 0 || strike > atlas->strike_count) return;
+
+    atlas_strike_t *entry = &atlas->strikes[strike - 1];
+    if (entry->refs && --entry->refs == 0) {
+        /* The id will be reused: its glyphs must not outlive it */
+        ocfx_atlas_flush(atlas);
+        drop_glyphs(atlas, false, strike);
+        entry->block_page = 0;
+    }
+}
+
+void ocfx_atlas_set_strike_block(ocfx_atlas_t *atlas, uint32_t strike, uint32_t page) {
+    if (!atlas || strike == 0 || strike > atlas->strike_count) return;
+    atlas->strikes[strike - 1].block_page = page + 1;
+}
+
+bool ocfx_atlas_has_strike_block(ocfx_atlas_t *atlas, uint32_t strike) {
+    if (!atlas || strike == 0 || strike > atlas->strike_count) return false;
+    return atlas->strikes[strike - 1].block_page != 0;
+}
+
+ocfx_glyph_t* ocfx_atlas_find(ocfx_atlas_t *atlas, uint64_t key) {
+    if (!atlas->index_capacity) return NULL;
+
+    size_t mask = atlas->index_capacity - 1;
+    for (size_t slot = glyph_hash(key, atlas->index_capacity);
+         atlas->index[slot]; slot = (slot + 1) & mask) {
+        ocfx_glyph_t *glyph = &atlas->glyphs[atlas->index[slot] - 1];
+        if (glyph->key == key) {
+            uint64_t frame = ocfx_render_get_frame(atlas->renderer);
+            glyph->last_used = frame;
+            atlas->pages[glyph->page].last_used = frame;
+            return glyph;
+        }
+    }
+    return NULL;
+}
+
+uint32_t ocfx_atlas_generation(ocfx_atlas_t *atlas) {
+    return atlas->generation;
+}
+
+void ocfx_atlas_touch_page(ocfx_atlas_t *atlas, uint32_t page) {
+    atlas->pages[page].last_used = ocfx_render_get_frame(atlas->renderer);
+}
+
+bool ocfx_atlas_upload(ocfx_atlas_t *atlas, const uint8_t *bitmap,
+                       int width, int height, int pitch,
+                       uint32_t *out_page, int *out_x, int *out_y) {
+    /* Reserve atlas space (may evict and compact the cache) */
+    atlas_page_t *page = atlas_alloc(atlas, width, height, out_x, out_y);
+    if (!page) return false;
+
+    /* Stage in the shadow; the texture is updated when the page is drawn.
+     * The padding is included so stale texels never bleed in. */
+    if (width > 0 && height > 0) {
+        for (int row = 0; row < height; row++) {
+            memcpy(page->pixels + (size_t)(*out_y + row) * page->width + *out_x,
+                   bitmap + (ptrdiff_t)row * pitch, (size_t)width);
+        }
+        mark_dirty(page, *out_x, *out_y,
+                   *out_x + width + OCFX_ATLAS_PADDING, *out_y + height + OCFX_ATLAS_PADDING);
+    }
+
+    *out_page = (uint32_t)(page - atlas->pages);
+    return true;
+}
+
+ocfx_glyph_t* ocfx_atlas_add(ocfx_atlas_t *atlas, uint64_t key, uint32_t page,
+                             int x, int y, int width, int height,
+                             float bearing_x, float bearing_y, float advance) {
+    /* Grow cache (and its index) if needed */
+    if (atlas->glyph_count >= atlas->glyph_capacity) {
+        size_t new_cap = atlas->glyph_capacity ? atlas->glyph_capacity * 2 : 128;
+        ocfx_glyph_t *glyphs = realloc(atlas->glyphs, new_cap * sizeof(ocfx_glyph_t));
+        if (!glyphs) return NULL;
+        atlas->glyphs = glyphs;
+        atlas->glyph_capacity = new_cap;
+    }
+    if ((atlas->glyph_count + 1) * 2 > atlas->index_capacity) {
+        size_t new_cap = atlas->index_capacity ? atlas->index_capacity * 2 : 256;
+        if (!rebuild_index(atlas, new_cap)) return NULL;
+    }
+
+    /* Add to cache */
+    size_t i = atlas->glyph_count++;
+    ocfx_glyph_t *glyph = &atlas->glyphs[i];
+    glyph->key = key;
+    glyph->page = page;
+    glyph->mode = atlas->strikes[(key >> 32) - 1].mode;
+    glyph->last_used = ocfx_render_get_frame(atlas->renderer);
+    glyph->atlas_x = (float)x;
+    glyph->atlas_y = (float)y;
+    glyph->width = (float)width;
+    glyph->height = (float)height;
+    glyph->bearing_x = bearing_x;
+    glyph->bearing_y = bearing_y;
+    glyph->advance = advance;
+    atlas->pages[page].last_used = glyph->last_used;
+
+    /* Insert into index */
+    size_t mask = atlas->index_capacity - 1;
+    size_t slot = glyph_hash(key, atlas->index_capacity);
+    while (atlas->index[slot]) {
+        slot = (slot + 1) & mask;
+    }
+    atlas->index[slot] = (uint32_t)(i + 1);
+
+    return glyph;
+}
+
+ocfx_glyph_t* ocfx_atlas_insert(ocfx_atlas_t *atlas, uint64_t key,
+                                const uint8_t *bitmap, int width, int height, int pitch,
+                                float bearing_x, float bearing_y, float advance) {
+    uint32_t page = 0;
+    int x = 0, y = 0;
+    if (!ocfx_atlas_upload(atlas, bitmap, width, height, pitch, &page, &x, &y)) return NULL;
+    return ocfx_atlas_add(atlas, key, page, x, y, width, height, bearing_x, bearing_y, advance);
+}
+
+void ocfx_atlas_set_budget(ocfx_atlas_t *atlas, size_t max_bytes, uint64_t max_ns) {
+    if (!atlas) return;
+    atlas->budget_bytes = max_bytes;
+    atlas->budget_ns = max_ns;
+}
+
+bool ocfx_atlas_budget_available(ocfx_atlas_t *atlas) {
+    uint64_t frame = ocfx_render_get_frame(atlas->renderer);
+    if (frame != atlas->budget_frame) {
+        atlas->budget_frame = frame;
+        atlas->spent_bytes = 0;
+        atlas->spent_ns = 0;
+    }
+
+    /* The first glyph of a frame is always allowed, so work never stalls */
+    return (!atlas->budget_bytes || atlas->spent_bytes < atlas->budget_bytes) &&
+           (!atlas->budget_ns || atlas->spent_ns < atlas->budget_ns);
+}
+
+void ocfx_atlas_budget_charge(ocfx_atlas_t *atlas, size_t bytes, uint64_t ns) {
+    atlas->spent_bytes += bytes;
+    atlas->spent_ns += ns;
+}
+
+int ocfx_atlas_get_max_size(ocfx_atlas_t *atlas) {
+    /* Largest block ocfx_atlas_upload accepts (page size minus padding) */
+    return atlas->max_size - OCFX_ATLAS_PADDING;
+}
+
+ocfx_text_vertex_t* ocfx_atlas_batch_reserve(ocfx_atlas_t *atlas, uint32_t page,
+                                             uint32_t mode, size_t quads) {
+    if (quads > OCFX_TEXT_BATCH_QUADS) return NULL;
+
+    if (atlas->quad_count &&
+        (atlas->batch_page != page || atlas->batch_mode != mode ||
+         atlas->quad_count + quads > OCFX_TEXT_BATCH_QUADS)) {
+        ocfx_atlas_flush(atlas);
+    }
+
+    atlas->batch_page = page;
+    atlas->batch_mode = mode;
+    ocfx_text_vertex_t *v = &atlas->vertices[atlas->quad_count * 4];
+    atlas->quad_count += quads;
+    return v;
+}
+
+void ocfx_atlas_push_glyph(ocfx_atlas_t *atlas, const ocfx_glyph_t *glyph,
+                           float pen_x, float pen_y, ocfx_rgba8_t color) {
+    if (glyph->width <= 0 || glyph->height <= 0) return;
+
+    ocfx_text_vertex_t *v = ocfx_atlas_batch_reserve(atlas, glyph->page, glyph->mode, 1);
+
+    float x0 = pen_x + glyph->bearing_x;
+    float y0 = pen_y - glyph->bearing_y;
+    float x1 = x0 + glyph->width;
+    float y1 = y0 + glyph->height;
+
+    float tx0 = glyph->atlas_x;
+    float ty0 = glyph->atlas_y;
+    float tx1 = tx0 + glyph->width;
+    float ty1 = ty0 + glyph->height;
+
+    /* Corners: top-left, top-right, bottom-left, bottom-right */
+    v[0] = (ocfx_text_vertex_t){x0, y0, tx0, ty0, color.r, color.g, color.b, color.a};
+    v[1] = (ocfx_text_vertex_t){x1, y0, tx1, ty0, color.r, color.g, color.b, color.a};
+    v[2] = (ocfx_text_vertex_t){x0, y1, tx0, ty1, color.r, color.g, color.b, color.a};
+    v[3] = (ocfx_text_vertex_t){x1, y1, tx1, ty1, color.r, color.g, color.b, color.a};
+}
+
+void ocfx_atlas_push_rect(ocfx_atlas_t *atlas, uint32_t mode, float x0, float y0,
+                          float x1, float y1, ocfx_rgba8_t color) {
+    if (x1 <= x0 || y1 <= y0) return;
+
+    /* Any page will do: stay on the batch's page if it has one */
+    uint32_t page = atlas->batch_page;
+    if (!atlas->quad_count || atlas->batch_mode != mode ||
+        page >= atlas->page_count || !atlas->pages[page].texture) {
+        page = (uint32_t)atlas->newest_page;
+        if (page >= atlas->page_count || !atlas->pages[page].texture) {
+            if (!add_page(atlas)) return;
+            page = (uint32_t)atlas->newest_page;
+        }
+    }
+
+    ocfx_text_vertex_t *v = ocfx_atlas_batch_reserve(atlas, page, mode, 1);
+
+    /* Sample the middle of the solid block: full coverage under filtering */
+    const float t = OCFX_ATLAS_SOLID * 0.5f;
+    v[0] = (ocfx_text_vertex_t){x0, y0, t, t, color.r, color.g, color.b, color.a};
+    v[1] = (ocfx_text_vertex_t){x1, y0, t, t, color.r, color.g, color.b, color.a};
+    v[2] = (ocfx_text_vertex_t){x0, y1, t, t, color.r, color.g, color.b, color.a};
+    v[3] = (ocfx_text_vertex_t){x1, y1, t, t, color.r, color.g, color.b, color.a};
+}
+
+void ocfx_atlas_push_glyph_transformed(ocfx_atlas_t *atlas, const ocfx_glyph_t *glyph,
+                                       float pen_x, float pen_y,
+                                       const ocfx_transform_t *transform, ocfx_rgba8_t color) {
+    if (glyph->width <= 0 || glyph->height <= 0) return;
+
+    ocfx_text_vertex_t *v = ocfx_atlas_batch_reserve(atlas, glyph->page, glyph->mode, 1);
+
+    /* Corners in text-local space, then mapped through the transform */
+    float x0 = pen_x + glyph->bearing_x;
+    float y0 = pen_y - glyph->bearing_y;
+    float x1 = x0 + glyph->width;
+    float y1 = y0 + glyph->height;
+    const ocfx_transform_t *m = transform;
+
+    float tx0 = glyph->atlas_x;
+    float ty0 = glyph->atlas_y;
+    float tx1 = tx0 + glyph->width;
+    float ty1 = ty0 + glyph->height;
+
+    v[0] = (ocfx_text_vertex_t){m->a * x0 + m->c * y0 + m->tx, m->b * x0 + m->d * y0 + m->ty,
+                                tx0, ty0, color.r, color.g, color.b, color.a};
+    v[1] = (ocfx_text_vertex_t){m->a * x1 + m->c * y0 + m->tx, m->b * x1 + m->d * y0 + m->ty,
+                                tx1, ty0, color.r, color.g, color.b, color.a};
+    v[2] = (ocfx_text_vertex_t){m->a * x0 + m->c * y1 + m->tx, m->b * x0 + m->d * y1 + m->ty,
+                                tx0, ty1, color.r, color.g, color.b, color.a};
+    v[3] = (ocfx_text_vertex_t){m->a * x1 + m->c * y1 + m->tx, m->b * x1 + m->d * y1 + m->ty,
+                                tx1, ty1, color.r, color.g, color.b, color.a};
+}
+
+void ocfx_atlas_flush(ocfx_atlas_t *atlas) {
+    if (!atlas || !atlas->quad_count) return;
+
+    int32_t vp_width, vp_height;
+    ocfx_render_get_viewport(atlas->renderer, &vp_width, &vp_height);
+
+    uint32_t mode = atlas->batch_mode;
+    glUseProgram(atlas->programs[mode]);
+    glUniform2f(atlas->u_resolution[mode], (float)vp_width, (float)vp_height);
+    glUniform1i(atlas->u_texture[mode], 0);
+
+    glActiveTexture(GL_TEXTURE0);
+    atlas_page_t *page = &atlas->pages[atlas->batch_page];
+    sync_page(page);
+    glBindTexture(GL_TEXTURE_2D, page->texture);
+
+    glBindVertexArray(atlas->vao);
+    glBindBuffer(GL_ARRAY_BUFFER, atlas->vbo);
+    glBufferData(GL_ARRAY_BUFFER, atlas->quad_count * 4 * sizeof(ocfx_text_vertex_t),
+                 atlas->vertices, GL_STREAM_DRAW);
+    glDrawElements(GL_TRIANGLES, (GLsizei)(atlas->quad_count * 6), GL_UNSIGNED_SHORT, 0);
+    glBindVertexArray(0);
+
+    atlas->quad_count = 0;
+}
+
+void ocfx_atlas_bind_page(ocfx_atlas_t *atlas, uint32_t page) {
+    atlas_page_t *p = &atlas->pages[page];
+    glActiveTexture(GL_TEXTURE0);
+    sync_page(p);
+    glBindTexture(GL_TEXTURE_2D, p->texture);
+}
+
+GLuint ocfx_atlas_get_shader(ocfx_atlas_t *atlas) {
+    return atlas ? atlas->programs[OCFX_ATLAS_MODE_BITMAP] : 0;
+}
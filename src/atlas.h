@@ -0,0 +1,159 @@
+/* OCFX - Glyph Atlas (internal)
+ * Renderer-wide glyph atlas and text quad batch, shared by all fonts
+ */
+
+#ifndef OCFX_ATLAS_H
+#define OCFX_ATLAS_H
+
+#include "ocfx/types.h"
+#include "ocfx/render.h"
+
+/* Atlas configuration (compile-time, suckless style) */
+#ifndef OCFX_ATLAS_PAGE_SIZE
+#define OCFX_ATLAS_PAGE_SIZE 2048     /* Maximum page size */
+#endif
+
+#ifndef OCFX_ATLAS_INITIAL_SIZE
+#define OCFX_ATLAS_INITIAL_SIZE 256   /* Pages start here and double on demand */
+#endif
+
+/* Default cap on GPU memory used by atlas pages (bytes).
+ * Once reached, the least recently used page is recycled. */
+#ifndef OCFX_ATLAS_MAX_BYTES
+#define OCFX_ATLAS_MAX_BYTES (4 * OCFX_ATLAS_PAGE_SIZE * OCFX_ATLAS_PAGE_SIZE)
+#endif
+
+#ifndef OCFX_TEXT_BATCH_QUADS
+#define OCFX_TEXT_BATCH_QUADS 4096    /* Quads per draw call (16-bit indices) */
+#endif
+
+/* Glyph key: strike (face + size + mode, see ocfx_atlas_acquire_strike)
+ * in the high word, glyph index in the low word. Subpixel strikes keep the
+ * phase in the top bits of the low word (OCFX_GLYPH_PHASE_SHIFT). */
+#define OCFX_GLYPH_KEY(strike, glyph_index) \
+    (((uint64_t)(strike) << 32) | (uint32_t)(glyph_index))
+
+#define OCFX_GLYPH_PHASE_SHIFT 30
+
+typedef struct ocfx_atlas_t ocfx_atlas_t;
+
+/* Strike render modes (each has its own fragment shader) */
+typedef enum {
+    OCFX_ATLAS_MODE_BITMAP = 0,   /* Coverage bitmaps, drawn at native size */
+    OCFX_ATLAS_MODE_SDF = 1,      /* Signed distance fields, drawn at any scale */
+    OCFX_ATLAS_MODE_COUNT,
+} ocfx_atlas_mode_t;
+
+/* Cached glyph */
+typedef struct {
+    uint64_t key;
+    uint32_t page;                /* Atlas page holding the bitmap */
+    uint32_t mode;                /* ocfx_atlas_mode_t of the strike */
+    uint64_t last_used;           /* Renderer frame this glyph was last used in */
+    float atlas_x, atlas_y;       /* Position in atlas page (pixels) */
+    float width, height;          /* Size in pixels */
+    float bearing_x, bearing_y;   /* Bearing in pixels */
+    float advance;                /* Advance in pixels */
+} ocfx_glyph_t;
+
+/* Text vertex: position, atlas texel, packed color */
+typedef struct {
+    float x, y;
+    float u, v;
+    uint8_t r, g, b, a;
+} ocfx_text_vertex_t;
+
+/* Color packed for vertex upload */
+typedef struct {
+    uint8_t r, g, b, a;
+} ocfx_rgba8_t;
+
+/* Lifetime (owned by the renderer) */
+ocfx_atlas_t* ocfx_atlas_create(ocfx_renderer_t *renderer);
+void ocfx_atlas_destroy(ocfx_atlas_t *atlas);
+void ocfx_atlas_set_limit(ocfx_atlas_t *atlas, size_t max_bytes);
+
+/* Strikes: fonts with the same face, size, mode and flags share one id.
+ * Releasing the last reference drops the strike's glyphs. */
+#define OCFX_STRIKE_SUBPIXEL 1u       /* Glyphs cached per subpixel phase */
+
+uint32_t ocfx_atlas_acquire_strike(ocfx_atlas_t *atlas, uint32_t face_id,
+                                   int size, uint32_t mode, uint32_t flags);
+void ocfx_atlas_release_strike(ocfx_atlas_t *atlas, uint32_t strike);
+
+/* Prepacked strike image (see ocfx_atlas_upload) of a strike: remembered
+ * until its page is evicted or the strike released, so fonts sharing the
+ * strike upload it once */
+void ocfx_atlas_set_strike_block(ocfx_atlas_t *atlas, uint32_t strike, uint32_t page);
+bool ocfx_atlas_has_strike_block(ocfx_atlas_t *atlas, uint32_t strike);
+
+/* Glyph cache. Returned pointers stay valid until the next insert. */
+ocfx_glyph_t* ocfx_atlas_find(ocfx_atlas_t *atlas, uint64_t key);
+ocfx_glyph_t* ocfx_atlas_insert(ocfx_atlas_t *atlas, uint64_t key,
+                                const uint8_t *bitmap, int width, int height, int pitch,
+                                float bearing_x, float bearing_y, float advance);
+
+/* Glyph positions handed out stay valid for as long as the generation
+ * is unchanged; it moves whenever glyphs are dropped (page eviction,
+ * strike release). Holders of cached quads touch their pages each frame
+ * so the LRU sees them as used. */
+uint32_t ocfx_atlas_generation(ocfx_atlas_t *atlas);
+void ocfx_atlas_touch_page(ocfx_atlas_t *atlas, uint32_t page);
+
+/* Two-step insert for prepacked images: upload a block of pixels, then
+ * register glyphs at positions inside it. Nothing is evicted between
+ * the two, so glyphs added right after the upload are safe. */
+bool ocfx_atlas_upload(ocfx_atlas_t *atlas, const uint8_t *bitmap,
+                       int width, int height, int pitch,
+                       uint32_t *out_page, int *out_x, int *out_y);
+ocfx_glyph_t* ocfx_atlas_add(ocfx_atlas_t *atlas, uint64_t key, uint32_t page,
+                             int x, int y, int width, int height,
+                             float bearing_x, float bearing_y, float advance);
+int ocfx_atlas_get_max_size(ocfx_atlas_t *atlas);
+
+/* Per-frame budget for new glyph work (0 = unlimited). Callers check
+ * before rasterizing/uploading and charge what they spent; the budget
+ * resets when the renderer starts a new frame. */
+void ocfx_atlas_set_budget(ocfx_atlas_t *atlas, size_t max_bytes, uint64_t max_ns);
+bool ocfx_atlas_budget_available(ocfx_atlas_t *atlas);
+void ocfx_atlas_budget_charge(ocfx_atlas_t *atlas, size_t bytes, uint64_t ns);
+
+/* Batching: quads accumulate until the page changes, the batch fills up or
+ * something else needs the GPU (primitives, clipping, end of frame). */
+ocfx_text_vertex_t* ocfx_atlas_batch_reserve(ocfx_atlas_t *atlas, uint32_t page,
+                                             uint32_t mode, size_t quads);
+void ocfx_atlas_push_glyph(ocfx_atlas_t *atlas, const ocfx_glyph_t *glyph,
+                           float pen_x, float pen_y, ocfx_rgba8_t color);
+void ocfx_atlas_push_glyph_transformed(ocfx_atlas_t *atlas, const ocfx_glyph_t *glyph,
+                                       float pen_x, float pen_y,
+                                       const ocfx_transform_t *transform, ocfx_rgba8_t color);
+void ocfx_atlas_flush(ocfx_atlas_t *atlas);
+
+/* Solid rectangle drawn from an opaque block every page reserves, so
+ * backgrounds share the batch (and draw call) of the text around them */
+void ocfx_atlas_push_rect(ocfx_atlas_t *atlas, uint32_t mode, float x0, float y0,
+                          float x1, float y1, ocfx_rgba8_t color);
+
+/* Upload a page's pending pixels and bind it to texture unit 0, for
+ * renderers drawing atlas glyphs with their own shader */
+void ocfx_atlas_bind_page(ocfx_atlas_t *atlas, uint32_t page);
+GLuint ocfx_atlas_get_shader(ocfx_atlas_t *atlas);
+
+/* Renderer accessor (defined in render.c) */
+ocfx_atlas_t* ocfx_renderer_get_atlas(ocfx_renderer_t *renderer);
+
+static inline uint8_t ocfx_atlas_unorm8(float v) {
+    if (v <= 0.0f) return 0;
+    if (v >= 1.0f) return 255;
+    return (uint8_t)(v * 255.0f + 0.5f);
+}
+
+static inline ocfx_rgba8_t ocfx_atlas_pack_color(ocfx_color_t color) {
+    ocfx_rgba8_t c = {
+        ocfx_atlas_unorm8(color.r), ocfx_atlas_unorm8(color.g),
+        ocfx_atlas_unorm8(color.b), ocfx_atlas_unorm8(color.a),
+    };
+    return c;
+}
+
+#endif /* OCFX_ATLAS_H */
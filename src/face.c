@@ -0,0 +1,152 @@
+/* OCFX - Font Face Registry Implementation
+ * Each font file is mapped once and opened with FT_New_Memory_Face; the
+ * face, its cmap and the file pages are shared by all sizes
+ */
+
+#define _POSIX_C_SOURCE 200809L  /* For strdup */
+
+#include "face.h"
+#include "strike.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* Registry state (process-wide) */
+static FT_Library ft_library;
+static ocfx_face_t *faces;
+static uint32_t next_face_id = 1;
+
+/* Map a whole file read-only */
+static const uint8_t* map_file(const char *path, size_t *size, struct stat *st) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return NULL;
+
+    if (fstat(fd, st) < 0 || st->st_size <= 0) {
+        close(fd);
+        return NULL;
+    }
+
+    void *data = mmap(NULL, (size_t)st->st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return NULL;
+
+    *size = (size_t)st->st_size;
+    return data;
+}
+
+ocfx_face_t* ocfx_face_acquire(const char *path) {
+    if (!path) return NULL;
+
+    /* Same file (by device and inode) means same face, whatever the path */
+    struct stat st;
+    if (stat(path, &st) < 0) return NULL;
+
+    for (ocfx_face_t *face = faces; face; face = face->next) {
+        if (face->dev == (uint64_t)st.st_dev && face->ino == (uint64_t)st.st_ino) {
+            face->refs++;
+            return face;
+        }
+    }
+
+    if (!ft_library && FT_Init_FreeType(&ft_library)) {
+        fprintf(stderr, "OCFX: Failed to initialize FreeType\n");
+        ft_library = NULL;
+        return NULL;
+    }
+
+    ocfx_face_t *face = calloc(1, sizeof(ocfx_face_t));
+    if (!face) return NULL;
+
+    face->data = map_file(path, &face->size, &st);
+    face->path = strdup(path);
+    if (!face->data || !face->path ||
+        FT_New_Memory_Face(ft_library, face->data, (FT_Long)face->size, 0, &face->ft_face)) {
+        if (face->data) munmap((void*)face->data, face->size);
+        free(face->path);
+        free(face);
+        if (!faces) {
+            FT_Done_FreeType(ft_library);
+            ft_library = NULL;
+        }
+        return NULL;
+    }
+
+    for (uint32_t c = 0; c < 256; c++) {
+        face->latin1_index[c] = FT_Get_Char_Index(face->ft_face, c);
+    }
+
+    face->id = next_face_id++;
+    face->dev = (uint64_t)st.st_dev;
+    face->ino = (uint64_t)st.st_ino;
+    face->refs = 1;
+    face->next = faces;
+    faces = face;
+    return face;
+}
+
+void ocfx_face_release(ocfx_face_t *face) {
+    if (!face || --face->refs > 0) return;
+
+    for (ocfx_face_t **link = &faces; *link; link = &(*link)->next) {
+        if (*link == face) {
+            *link = face->next;
+            break;
+        }
+    }
+
+    FT_Done_Face(face->ft_face);
+    munmap((void*)face->data, face->size);
+    free(face->path);
+    free(face->coverage_index);
+    free(face->coverage_bits);
+    free(face);
+
+    /* Last face gone: release the library too */
+    if (!faces) {
+        FT_Done_FreeType(ft_library);
+        ft_library = NULL;
+    }
+}
+
+uint64_t ocfx_face_hash(ocfx_face_t *face) {
+    if (!face->hashed) {
+        face->hash = ocfx_strike_hash(face->data, face->size);
+        face->hashed = true;
+    }
+    return face->hash;
+}
+
+bool ocfx_face_load_coverage(ocfx_face_t *face) {
+    if (face->coverage_index) return true;
+
+    uint16_t *index = calloc(OCFX_FACE_COVERAGE_BLOCKS, sizeof(uint16_t));
+    if (!index) return false;
+
+    /* Number the blocks that have any mapped codepoint (bitmap 0 stays
+     * empty and is shared by all other blocks) */
+    FT_UInt glyph_index;
+    FT_ULong c;
+    uint16_t bitmaps = 1;
+    for (c = FT_Get_First_Char(face->ft_face, &glyph_index); glyph_index;
+         c = FT_Get_Next_Char(face->ft_face, c, &glyph_index)) {
+        if (c < 0x110000u && !index[c >> 8]) index[c >> 8] = bitmaps++;
+    }
+
+    uint8_t *bits = calloc((size_t)bitmaps * 32, 1);
+    if (!bits) {
+        free(index);
+        return false;
+    }
+    for (c = FT_Get_First_Char(face->ft_face, &glyph_index); glyph_index;
+         c = FT_Get_Next_Char(face->ft_face, c, &glyph_index)) {
+        if (c < 0x110000u) bits[(size_t)index[c >> 8] * 32 + ((c & 0xFF) >> 3)] |= 1u << (c & 7);
+    }
+
+    face->coverage_index = index;
+    face->coverage_bits = bits;
+    return true;
+}
@@ -0,0 +1,61 @@
+/* OCFX - Font Face Registry (internal)
+ * Memory-mapped FreeType faces shared by every font loaded from a file
+ */
+
+#ifndef OCFX_FACE_H
+#define OCFX_FACE_H
+
+#include "ocfx/types.h"
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_SIZES_H
+
+/* Shared face: one mapping and one FT_Face per font file. Fonts of
+ * different sizes attach their own FT_Size to it. */
+typedef struct ocfx_face_t {
+    uint32_t id;                  /* Unique while registered */
+    char *path;
+    const uint8_t *data;          /* Read-only mapping of the file */
+    size_t size;
+    FT_Face ft_face;
+
+    /* Content hash (computed on first use, see ocfx_face_hash) */
+    uint64_t hash;
+    bool hashed;
+
+    /* Glyph indices for the Latin-1 range (others go through the cmap) */
+    uint32_t latin1_index[256];
+
+    /* Cmap coverage, built on demand (see ocfx_face_load_coverage): one
+     * bitmap number per block of 256 codepoints, 0 for an empty block,
+     * and 32 bytes of bits per bitmap */
+    uint16_t *coverage_index;
+    uint8_t *coverage_bits;
+
+    /* Registry bookkeeping */
+    uint64_t dev, ino;
+    uint32_t refs;
+    struct ocfx_face_t *next;
+} ocfx_face_t;
+
+/* Registry (render thread only) */
+ocfx_face_t* ocfx_face_acquire(const char *path);
+void ocfx_face_release(ocfx_face_t *face);
+
+/* Hash of the file contents, stable across processes */
+uint64_t ocfx_face_hash(ocfx_face_t *face);
+
+/* Build the coverage bitmap from the cmap (once per face) */
+bool ocfx_face_load_coverage(ocfx_face_t *face);
+
+#define OCFX_FACE_COVERAGE_BLOCKS (0x110000u >> 8)
+
+/* Does the face map codepoint to a glyph? One bit test, no cmap lookup.
+ * Requires ocfx_face_load_coverage. */
+static inline bool ocfx_face_covers(const ocfx_face_t *face, uint32_t codepoint) {
+    if (codepoint >= 0x110000u) return false;
+    const uint8_t *bits = face->coverage_bits + (size_t)face->coverage_index[codepoint >> 8] * 32;
+    return (bits[(codepoint & 0xFF) >> 3] >> (codepoint & 7)) & 1;
+}
+
+#endif /* OCFX_FACE_H */
@@ -0,0 +1,31 @@
+/* OCFX - Font Internals (internal)
+ * Glyph access and measurement for components built on the text module
+ * (cell grid, text view, editor buffer)
+ */
+
+#ifndef OCFX_FONT_H
+#define OCFX_FONT_H
+
+#include "ocfx/text.h"
+#include "atlas.h"
+
+ocfx_atlas_t* ocfx_font_get_atlas(ocfx_font_t *font);
+
+/* Call before a burst of lookups: uploads finished background glyphs and,
+ * in OCFX_GLYPH_WAIT mode, rasterizes the missing ones among codepoints */
+void ocfx_font_prepare_glyphs(ocfx_font_t *font, const uint32_t *codepoints, size_t count);
+
+/* Glyph for a codepoint, rasterized or queued as the loading mode says.
+ * *placeholder is set when a blank stand-in is returned (the real glyph
+ * arrives on a later frame). The pointer is valid until the next lookup. */
+ocfx_glyph_t* ocfx_font_lookup_glyph(ocfx_font_t *font, uint32_t codepoint,
+                                     bool *placeholder);
+
+/* Advance of a codepoint as text measurement sees it (no rasterization) */
+float ocfx_font_codepoint_advance(ocfx_font_t *font, uint32_t codepoint);
+
+/* Bytes of text[0, len) whose glyphs start left of max_width, found
+ * without looking past them (NULs are skipped as in the _n draws) */
+size_t ocfx_font_fit_n(ocfx_font_t *font, const char *text, size_t len, float max_width);
+
+#endif /* OCFX_FONT_H */
@@ -0,0 +1,467 @@
+/* OCFX - System Font Index Implementation
+ * The font directories are walked once; FreeType opens each font file for
+ * its family and style names. The result is saved as a flat file together
+ * with the modification time of every directory visited. Later runs only
+ * stat those directories: if none changed, the file is loaded and lookups
+ * go straight to a hash table over family names.
+ */
+
+#define _DEFAULT_SOURCE  /* For d_type and st_mtim */
+
+#include "fontindex.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#define OCFX_FONT_INDEX_MAGIC "OCFXFIX1"
+#define OCFX_FONT_INDEX_VERSION 1
+#define OCFX_FONT_INDEX_DEPTH 8   /* Subdirectory levels walked below a root */
+
+/* File layout: header, directory records, font records, string blob.
+ * Strings are NUL terminated and referenced by blob offset. */
+typedef struct {
+    char magic[8];                /* OCFX_FONT_INDEX_MAGIC */
+    uint32_t version;
+    uint32_t dir_count;
+    uint32_t font_count;
+    uint32_t strings_size;
+} index_header_t;
+
+/* Directory visited by the scan; mtime_sec -1 = did not exist */
+typedef struct {
+    int64_t mtime_sec;
+    int64_t mtime_nsec;
+    uint32_t path;
+    uint32_t reserved;
+} index_dir_t;
+
+typedef struct {
+    uint32_t family;
+    uint32_t style;
+    uint32_t path;
+    uint32_t hash;                /* Of the lowercased family name */
+} index_font_t;
+
+/* Loaded index (process-wide, render thread only) */
+typedef struct {
+    uint8_t *data;
+    const index_header_t *header;
+    const index_dir_t *dirs;
+    const index_font_t *fonts;
+    const char *strings;
+
+    uint32_t *slots;              /* Open addressing by family: font index + 1 */
+    uint32_t slot_mask;
+} font_index_t;
+
+static font_index_t font_index;
+static bool font_index_tried;
+
+/* ============================================================================
+ * Helpers
+ * ============================================================================ */
+
+static uint32_t family_hash(const char *name) {
+    uint32_t h = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *)name; *p; p++) {
+        unsigned char c = *p;
+        if (c >= 'A' && c <= 'Z') c = (unsigned char)(c - 'A' + 'a');
+        h = (h ^ c) * 16777619u;
+    }
+    return h;
+}
+
+static bool is_regular_style(const char *style) {
+    static const char *const names[] = {"Regular", "Book", "Normal", "Roman", "Medium"};
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (strcasecmp(style, names[i]) == 0) return true;
+    }
+    return false;
+}
+
+static bool is_font_file(const char *name) {
+    const char *dot = strrchr(name, '.');
+    return dot && (strcasecmp(dot, ".ttf") == 0 || strcasecmp(dot, ".otf") == 0 ||
+                   strcasecmp(dot, ".ttc") == 0 || strcasecmp(dot, ".otc") == 0);
+}
+
+/* Cache file: $XDG_CACHE_HOME/ocfx/font-index (or ~/.cache/ocfx/...) */
+static bool cache_path(char *path, size_t size) {
+    const char *cache = getenv("XDG_CACHE_HOME");
+    const char *home = getenv("HOME");
+    int n;
+    if (cache && *cache) {
+        n = snprintf(path, size, "%s/ocfx/font-index", cache);
+    } else if (home && *home) {
+        n = snprintf(path, size, "%s/.cache/ocfx/font-index", home);
+    } else {
+        return false;
+    }
+    return n > 0 && (size_t)n < size;
+}
+
+/* Directories to scan, in priority order (user fonts first) */
+static size_t font_roots(char roots[][512], size_t max) {
+    size_t count = 0;
+    const char *home = getenv("HOME");
+    const char *data_home = getenv("XDG_DATA_HOME");
+    const char *data_dirs = getenv("XDG_DATA_DIRS");
+
+    if (data_home && *data_home) {
+        snprintf(roots[count++], 512, "%s/fonts", data_home);
+    } else if (home && *home) {
+        snprintf(roots[count++], 512, "%s/.local/share/fonts", home);
+    }
+    if (home && *home) snprintf(roots[count++], 512, "%s/.fonts", home);
+
+    if (!data_dirs || !*data_dirs) data_dirs = "/usr/local/share:/usr/share";
+    while (*data_dirs && count < max) {
+        size_t len = strcspn(data_dirs, ":");
+        if (len > 0 && len < 500) {
+            snprintf(roots[count++], 512, "%.*s/fonts", (int)len, data_dirs);
+        }
+        data_dirs += len;
+        if (*data_dirs == ':') data_dirs++;
+    }
+    return count;
+}
+
+/* ============================================================================
+ * Building
+ * ============================================================================ */
+
+typedef struct {
+    index_dir_t *dirs;
+    size_t dir_count, dir_capacity;
+    index_font_t *fonts;
+    size_t font_count, font_capacity;
+    char *strings;
+    size_t strings_size, strings_capacity;
+    FT_Library library;
+    bool failed;
+} index_builder_t;
+
+static bool grow(void **array, size_t *capacity, size_t need, size_t size) {
+    if (need <= *capacity) return true;
+    size_t cap = *capacity ? *capacity * 2 : 64;
+    while (cap < need) cap *= 2;
+    void *grown = realloc(*array, cap * size);
+    if (!grown) return false;
+    *array = grown;
+    *capacity = cap;
+    return true;
+}
+
+static uint32_t add_string(index_builder_t *b, const char *s) {
+    size_t len = strlen(s) + 1;
+    if (!grow((void **)&b->strings, &b->strings_capacity, b->strings_size + len, 1)) {
+        b->failed = true;
+        return 0;
+    }
+    uint32_t offset = (uint32_t)b->strings_size;
+    memcpy(b->strings + offset, s, len);
+    b->strings_size += len;
+    return offset;
+}
+
+static void add_dir(index_builder_t *b, const char *path, const struct stat *st) {
+    if (!grow((void **)&b->dirs, &b->dir_capacity, b->dir_count + 1, sizeof(index_dir_t))) {
+        b->failed = true;
+        return;
+    }
+    b->dirs[b->dir_count++] = (index_dir_t){
+        .mtime_sec = st ? (int64_t)st->st_mtim.tv_sec : -1,
+        .mtime_nsec = st ? (int64_t)st->st_mtim.tv_nsec : 0,
+        .path = add_string(b, path),
+    };
+}
+
+/* Read the names of a font file (first face of a collection, the one
+ * ocfx_font_load opens) */
+static void add_font(index_builder_t *b, const char *path) {
+    FT_Face face;
+    if (FT_New_Face(b->library, path, 0, &face)) return;
+
+    if (face->family_name &&
+        grow((void **)&b->fonts, &b->font_capacity, b->font_count + 1, sizeof(index_font_t))) {
+        index_font_t *font = &b->fonts[b->font_count++];
+        font->family = add_string(b, face->family_name);
+        font->style = add_string(b, face->style_name ? face->style_name : "Regular");
+        font->path = add_string(b, path);
+        font->hash = family_hash(face->family_name);
+    }
+    FT_Done_Face(face);
+}
+
+static void scan_dir(index_builder_t *b, const char *path, int depth) {
+    struct stat st;
+    if (stat(path, &st) < 0 || !S_ISDIR(st.st_mode)) {
+        if (depth == 0) add_dir(b, path, NULL);  /* Roots are watched even if missing */
+        return;
+    }
+    add_dir(b, path, &st);
+
+    DIR *dir = opendir(path);
+    if (!dir) return;
+
+    struct dirent *entry;
+    char child[4096];
+    while ((entry = readdir(dir)) != NULL && !b->failed) {
+        if (entry->d_name[0] == '.') continue;
+        int n = snprintf(child, sizeof(child), "%s/%s", path, entry->d_name);
+        if (n < 0 || (size_t)n >= sizeof(child)) continue;
+
+        bool is_dir = entry->d_type == DT_DIR;
+        bool is_file = entry->d_type == DT_REG;
+        if (entry->d_type == DT_UNKNOWN || entry->d_type == DT_LNK) {
+            struct stat cst;
+            if (stat(child, &cst) < 0) continue;
+            is_dir = S_ISDIR(cst.st_mode);
+            is_file = S_ISREG(cst.st_mode);
+        }
+
+        if (is_dir && depth < OCFX_FONT_INDEX_DEPTH) {
+            scan_dir(b, child, depth + 1);
+        } else if (is_file && is_font_file(entry->d_name)) {
+            add_font(b, child);
+        }
+    }
+    closedir(dir);
+}
+
+/* Walk the roots and serialize the result in the file layout */
+static uint8_t* build_index(size_t *size) {
+    index_builder_t b = {0};
+    if (FT_Init_FreeType(&b.library)) return NULL;
+
+    char roots[8][512];
+    size_t root_count = font_roots(roots, 8);
+    add_string(&b, "");  /* Offset 0: empty string */
+    for (size_t i = 0; i < root_count; i++) scan_dir(&b, roots[i], 0);
+    FT_Done_FreeType(b.library);
+
+    uint8_t *data = NULL;
+    if (!b.failed) {
+        size_t dirs_size = b.dir_count * sizeof(index_dir_t);
+        size_t fonts_size = b.font_count * sizeof(index_font_t);
+        *size = sizeof(index_header_t) + dirs_size + fonts_size + b.strings_size;
+        data = malloc(*size);
+    }
+    if (data) {
+        index_header_t header = {
+            .version = OCFX_FONT_INDEX_VERSION,
+            .dir_count = (uint32_t)b.dir_count,
+            .font_count = (uint32_t)b.font_count,
+            .strings_size = (uint32_t)b.strings_size,
+        };
+        memcpy(header.magic, OCFX_FONT_INDEX_MAGIC, 8);
+
+        uint8_t *p = data;
+        memcpy(p, &header, sizeof(header));
+        p += sizeof(header);
+        if (b.dir_count) memcpy(p, b.dirs, b.dir_count * sizeof(index_dir_t));
+        p += b.dir_count * sizeof(index_dir_t);
+        if (b.font_count) memcpy(p, b.fonts, b.font_count * sizeof(index_font_t));
+        p += b.font_count * sizeof(index_font_t);
+        memcpy(p, b.strings, b.strings_size);
+    }
+
+    free(b.dirs);
+    free(b.fonts);
+    free(b.strings);
+    return data;
+}
+
+/* ============================================================================
+ * Loading
+ * ============================================================================ */
+
+/* Point the index at a serialized image (taking ownership) and hash it */
+static bool open_index(uint8_t *data, size_t size) {
+    const index_header_t *h = (const index_header_t *)data;
+    if (size < sizeof(index_header_t) || memcmp(h->magic, OCFX_FONT_INDEX_MAGIC, 8) != 0 ||
+        h->version != OCFX_FONT_INDEX_VERSION) {
+        return false;
+    }
+
+    size_t dirs_size = (size_t)h->dir_count * sizeof(index_dir_t);
+    size_t fonts_size = (size_t)h->font_count * sizeof(index_font_t);
+    if (size != sizeof(index_header_t) + dirs_size + fonts_size + h->strings_size ||
+        h->strings_size == 0) {
+        return false;
+    }
+
+    const index_dir_t *dirs = (const index_dir_t *)(data + sizeof(index_header_t));
+    const index_font_t *fonts = (const index_font_t *)((const uint8_t *)dirs + dirs_size);
+    const char *strings = (const char *)fonts + fonts_size;
+    if (strings[h->strings_size - 1] != '\0') return false;
+    for (uint32_t i = 0; i < h->dir_count; i++) {
+        if (dirs[i].path >= h->strings_size) return false;
+    }
+    for (uint32_t i = 0; i < h->font_count; i++) {
+        if (fonts[i].family >= h->strings_size || fonts[i].style >= h->strings_size ||
+            fonts[i].path >= h->strings_size) {
+            return false;
+        }
+    }
+
+    /* Table at most half full */
+    uint32_t slots = 16;
+    while (slots < h->font_count * 2u) slots *= 2;
+    uint32_t *table = calloc(slots, sizeof(uint32_t));
+    if (!table) return false;
+    for (uint32_t i = 0; i < h->font_count; i++) {
+        uint32_t slot = fonts[i].hash & (slots - 1);
+        while (table[slot]) slot = (slot + 1) & (slots - 1);
+        table[slot] = i + 1;
+    }
+
+    font_index = (font_index_t){data, h, dirs, fonts, strings, table, slots - 1};
+    return true;
+}
+
+static uint8_t* read_file(const char *path, size_t *size) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+
+    uint8_t *data = NULL;
+    long len = (fseek(f, 0, SEEK_END) == 0) ? ftell(f) : -1;
+    if (len > 0 && fseek(f, 0, SEEK_SET) == 0 && (data = malloc((size_t)len)) != NULL) {
+        if (fread(data, 1, (size_t)len, f) != (size_t)len) {
+            free(data);
+            data = NULL;
+        }
+    }
+    fclose(f);
+    *size = data ? (size_t)len : 0;
+    return data;
+}
+
+/* Does every directory still have the mtime it had when scanned? */
+static bool index_current(void) {
+    for (uint32_t i = 0; i < font_index.header->dir_count; i++) {
+        const index_dir_t *dir = &font_index.dirs[i];
+        struct stat st;
+        if (stat(font_index.strings + dir->path, &st) < 0 || !S_ISDIR(st.st_mode)) {
+            if (dir->mtime_sec != -1) return false;
+            continue;
+        }
+        if (dir->mtime_sec != (int64_t)st.st_mtim.tv_sec ||
+            dir->mtime_nsec != (int64_t)st.st_mtim.tv_nsec) {
+            return false;
+        }
+    }
+
+    /* A root added to the search path since is not in the file at all */
+    char roots[8][512];
+    size_t root_count = font_roots(roots, 8);
+    for (size_t r = 0; r < root_count; r++) {
+        bool found = false;
+        for (uint32_t i = 0; i < font_index.header->dir_count && !found; i++) {
+            found = strcmp(font_index.strings + font_index.dirs[i].path, roots[r]) == 0;
+        }
+        if (!found) return false;
+    }
+    return true;
+}
+
+static void close_index(void) {
+    free(font_index.data);
+    free(font_index.slots);
+    memset(&font_index, 0, sizeof(font_index));
+}
+
+/* Write atomically (temp file + rename), creating the cache directories */
+static void save_index(const char *path, const uint8_t *data, size_t size) {
+    char dir[4096];
+    snprintf(dir, sizeof(dir), "%s", path);
+    for (char *slash = strchr(dir + 1, '/'); slash; slash = strchr(slash + 1, '/')) {
+        *slash = '\0';
+        mkdir(dir, 0755);
+        *slash = '/';
+    }
+
+    char tmp[4096];
+    int n = snprintf(tmp, sizeof(tmp), "%s.%ld", path, (long)getpid());
+    if (n < 0 || (size_t)n >= sizeof(tmp)) return;
+
+    FILE *f = fopen(tmp, "wb");
+    if (!f) return;
+    bool ok = fwrite(data, 1, size, f) == size;
+    ok = (fclose(f) == 0) && ok;
+    if (!ok || rename(tmp, path) != 0) unlink(tmp);
+}
+
+static bool load_index(void) {
+    if (font_index_tried) return font_index.data != NULL;
+    font_index_tried = true;
+
+    char path[4096];
+    bool have_path = cache_path(path, sizeof(path));
+
+    size_t size;
+    uint8_t *data = have_path ? read_file(path, &size) : NULL;
+    if (data) {
+        if (open_index(data, size) && index_current()) return true;
+        if (font_index.data) {
+            close_index();
+        } else {
+            free(data);
+        }
+    }
+
+    /* Missing or stale: scan, then keep the result for the next run */
+    data = build_index(&size);
+    if (!data) {
+        fprintf(stderr, "OCFX: Failed to index system fonts\n");
+        return false;
+    }
+    if (have_path) save_index(path, data, size);
+    if (!open_index(data, size)) {
+        free(data);
+        return false;
+    }
+    return true;
+}
+
+/* ============================================================================
+ * Lookup
+ * ============================================================================ */
+
+bool ocfx_font_index_find(const char *family, const char *style, char *path, size_t path_size) {
+    if (!family || !*family || !path || path_size == 0 || !load_index()) return false;
+
+    uint32_t hash = family_hash(family);
+    uint32_t slot = hash & font_index.slot_mask;
+    const index_font_t *best = NULL;
+    int best_score = 0;
+
+    /* Fonts of one family share a hash, so they sit in one probe run */
+    while (font_index.slots[slot]) {
+        const index_font_t *font = &font_index.fonts[font_index.slots[slot] - 1];
+        if (font->hash == hash && strcasecmp(font_index.strings + font->family, family) == 0) {
+            const char *font_style = font_index.strings + font->style;
+            int score = 1;
+            if (style && strcasecmp(font_style, style) == 0) {
+                score = 4;
+            } else if (is_regular_style(font_style)) {
+                score = (!style || is_regular_style(style)) ? 3 : 2;
+            }
+            if (score > best_score) {
+                best = font;
+                best_score = score;
+            }
+        }
+        slot = (slot + 1) & font_index.slot_mask;
+    }
+
+    if (!best) return false;
+    int n = snprintf(path, path_size, "%s", font_index.strings + best->path);
+    return n > 0 && (size_t)n < path_size;
+}
@@ -0,0 +1,15 @@
+/* OCFX - System Font Index (internal)
+ * Family/style lookup over the standard font directories, cached on disk
+ */
+
+#ifndef OCFX_FONTINDEX_H
+#define OCFX_FONTINDEX_H
+
+#include "ocfx/types.h"
+
+/* Path of the installed font whose family matches (case-insensitive),
+ * preferring an exact style match, then a regular face, then any. style
+ * may be NULL for regular. The index is built or loaded on first use. */
+bool ocfx_font_index_find(const char *family, const char *style, char *path, size_t path_size);
+
+#endif /* OCFX_FONTINDEX_H */
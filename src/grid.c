@@ -0,0 +1,689 @@
+/* OCFX - Cell Grid Implementation
+ * Every cell owns one instance in a GPU buffer (glyph rectangle, offset,
+ * colors); the vertex shader places it from the instance index, so a
+ * frame is one background pass plus one glyph pass per atlas page in use.
+ * Changed cells are tracked per row and re-uploaded as column ranges.
+ * Scrolling rotates a ring-buffer row offset instead of moving cells.
+ */
+
+#include "ocfx/grid.h"
+#include "atlas.h"
+#include "font.h"
+#include "utf8.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <math.h>
+
+#define OCFX_GRID_ASCII 128          /* Codepoints with a per-grid glyph cache */
+
+/* Glyph rectangle as stored in an instance (all zero = no glyph) */
+typedef struct {
+    uint16_t u, v, w, h;          /* Atlas texels */
+    int16_t ox, oy;               /* Offset of the bitmap from the cell's top-left */
+    uint16_t page;
+} grid_glyph_t;
+
+/* Per-cell GPU instance (24 bytes) */
+typedef struct {
+    uint16_t u, v, w, h;
+    int16_t ox, oy;
+    ocfx_rgba8_t fg;
+    ocfx_rgba8_t bg;
+    uint16_t page;
+    uint16_t attrs;               /* Underline / strike bits for the background pass */
+} grid_instance_t;
+
+/* Grid structure (opaque to users) */
+struct ocfx_grid_t {
+    ocfx_renderer_t *renderer;
+    ocfx_font_t *font;
+    ocfx_atlas_t *atlas;
+
+    int cols, rows;
+    int top;                      /* Physical row shown as row 0 */
+    float cell_width, cell_height;
+    int ascent;
+    ocfx_grid_cell_t blank;       /* Fill for cleared and scrolled-in cells */
+
+    /* Cells and their instances, both in physical row order */
+    ocfx_grid_cell_t *cells;
+    grid_instance_t *instances;
+    uint32_t *scratch;            /* Codepoints of dirty cells, one per cell */
+
+    /* Dirty columns [lo, hi) per physical row, and rows that drew a
+     * placeholder and are repacked next frame */
+    int *dirty_lo, *dirty_hi;
+    uint8_t *retry;
+    int dirty_rows;
+    bool retry_pending;
+
+    /* Cells drawing from each atlas page; the glyph pass skips pages at 0 */
+    uint32_t *page_cells;
+    size_t page_slots;
+
+    /* Glyphs of ASCII codepoints, valid for one atlas generation */
+    grid_glyph_t ascii[OCFX_GRID_ASCII];
+    uint8_t ascii_ready[OCFX_GRID_ASCII];
+    uint32_t generation;
+
+    /* GPU resources */
+    GLuint program;
+    GLuint vao, vbo;
+    GLint u_resolution, u_origin, u_cell, u_cols, u_rows, u_top;
+    GLint u_pass, u_page, u_texture, u_sdf, u_underline, u_strike;
+};
+
+/* Cell vertex shader: corner from the vertex id, cell from the instance
+ * id (rotated by u_top), glyph quads outside the drawn page collapse */
+static const char *grid_vertex_shader =
+    "#version 300 es\n"
+    "precision highp float;\n"
+    "precision highp int;\n"
+    "layout(location = 0) in uvec4 a_glyph;\n"
+    "layout(location = 1) in ivec2 a_offset;\n"
+    "layout(location = 2) in vec4 a_fg;\n"
+    "layout(location = 3) in vec4 a_bg;\n"
+    "layout(location = 4) in uvec2 a_info;\n"
+    "uniform vec2 u_resolution;\n"
+    "uniform vec2 u_origin;\n"
+    "uniform vec2 u_cell;\n"
+    "uniform int u_cols;\n"
+    "uniform int u_rows;\n"
+    "uniform int u_top;\n"
+    "uniform int u_pass;\n"
+    "uniform uint u_page;\n"
+    "uniform sampler2D u_texture;\n"
+    "out vec2 v_texcoord;\n"
+    "out vec2 v_local;\n"
+    "out vec4 v_fg;\n"
+    "out vec4 v_bg;\n"
+    "flat out uint v_attrs;\n"
+    "void main() {\n"
+    "    vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1));\n"
+    "    int row = gl_InstanceID / u_cols;\n"
+    "    int col = gl_InstanceID - row * u_cols;\n"
+    "    row = (row - u_top + u_rows) % u_rows;\n"
+    "    vec2 cell = u_origin + vec2(float(col), float(row)) * u_cell;\n"
+    "    vec2 pos;\n"
+    "    if (u_pass == 0) {\n"
+    "        pos = cell + corner * u_cell;\n"
+    "        v_local = corner * u_cell;\n"
+    "        v_texcoord = vec2(0.0);\n"
+    "    } else {\n"
+    "        if (a_info.x != u_page || a_glyph.z == 0u) {\n"
+    "            gl_Position = vec4(2.0, 2.0, 2.0, 1.0);\n"
+    "            return;\n"
+    "        }\n"
+    "        vec2 size = vec2(a_glyph.zw);\n"
+    "        pos = cell + vec2(a_offset) + corner * size;\n"
+    "        v_local = vec2(0.0);\n"
+    "        v_texcoord = (vec2(a_glyph.xy) + corner * size) /\n"
+    "                     vec2(textureSize(u_texture, 0));\n"
+    "    }\n"
+    "    vec2 clip_pos = (pos / u_resolution) * 2.0 - 1.0;\n"
+    "    clip_pos.y = -clip_pos.y;\n"
+    "    gl_Position = vec4(clip_pos, 0.0, 1.0);\n"
+    "    v_fg = a_fg;\n"
+    "    v_bg = a_bg;\n"
+    "    v_attrs = a_info.y;\n"
+    "}\n";
+
+/* Cell fragment shader: backgrounds with underline / strike bands, or
+ * glyph coverage (distance fields are thresholded like ocfx text) */
+static const char *grid_fragment_shader =
+    "#version 300 es\n"
+    "precision highp float;\n"
+    "precision highp int;\n"
+    "in vec2 v_texcoord;\n"
+    "in vec2 v_local;\n"
+    "in vec4 v_fg;\n"
+    "in vec4 v_bg;\n"
+    "flat in uint v_attrs;\n"
+    "out vec4 fragColor;\n"
+    "uniform int u_pass;\n"
+    "uniform int u_sdf;\n"
+    "uniform sampler2D u_texture;\n"
+    "uniform vec2 u_underline;\n"
+    "uniform float u_strike;\n"
+    "void main() {\n"
+    "    if (u_pass == 0) {\n"
+    "        float y = v_local.y;\n"
+    "        bool under = (v_attrs & 1u) != 0u && y >= u_underline.x &&\n"
+    "                     y < u_underline.x + u_underline.y;\n"
+    "        bool strike = (v_attrs & 2u) != 0u && y >= u_strike &&\n"
+    "                      y < u_strike + u_underline.y;\n"
+    "        fragColor = (under || strike) ? v_fg : v_bg;\n"
+    "        return;\n"
+    "    }\n"
+    "    float alpha = texture(u_texture, v_texcoord).r;\n"
+    "    if (u_sdf != 0) {\n"
+    "        float width = max(fwidth(alpha) * 0.7, 1e-4);\n"
+    "        alpha = smoothstep(0.5 - width, 0.5 + width, alpha);\n"
+    "    }\n"
+    "    fragColor = vec4(v_fg.rgb, v_fg.a * alpha);\n"
+    "}\n";
+
+static GLuint compile_grid_shader(GLenum type, const char *source) {
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+
+    GLint success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        char info_log[512];
+        glGetShaderInfoLog(shader, sizeof(info_log), NULL, info_log);
+        fprintf(stderr, "OCFX: Grid shader compilation failed: %s\n", info_log);
+        return 0;
+    }
+    return shader;
+}
+
+static GLuint create_grid_program(void) {
+    GLuint vert = compile_grid_shader(GL_VERTEX_SHADER, grid_vertex_shader);
+    GLuint frag = compile_grid_shader(GL_FRAGMENT_SHADER, grid_fragment_shader);
+
+    if (!vert || !frag) return 0;
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vert);
+    glAttachShader(program, frag);
+    glLinkProgram(program);
+
+    GLint success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        char info_log[512];
+        glGetProgramInfoLog(program, sizeof(info_log), NULL, info_log);
+        fprintf(stderr, "OCFX: Grid shader linking failed: %s\n", info_log);
+        return 0;
+    }
+
+    glDeleteShader(vert);
+    glDeleteShader(frag);
+
+    return program;
+}
+
+/* ============================================================================
+ * Dirty tracking
+ * ============================================================================ */
+
+static inline int physical_row(const ocfx_grid_t *grid, int row) {
+    return (row + grid->top) % grid->rows;
+}
+
+static void mark_dirty(ocfx_grid_t *grid, int row, int lo, int hi) {
+    if (grid->dirty_lo[row] >= grid->dirty_hi[row]) {
+        grid->dirty_lo[row] = lo;
+        grid->dirty_hi[row] = hi;
+        grid->dirty_rows++;
+        return;
+    }
+    if (lo < grid->dirty_lo[row]) grid->dirty_lo[row] = lo;
+    if (hi > grid->dirty_hi[row]) grid->dirty_hi[row] = hi;
+}
+
+static void mark_all_dirty(ocfx_grid_t *grid) {
+    for (int row = 0; row < grid->rows; row++) {
+        grid->dirty_lo[row] = 0;
+        grid->dirty_hi[row] = grid->cols;
+    }
+    grid->dirty_rows = grid->rows;
+}
+
+/* Blank a physical row */
+static void fill_row(ocfx_grid_t *grid, int row) {
+    ocfx_grid_cell_t *cells = &grid->cells[(size_t)row * grid->cols];
+    for (int col = 0; col < grid->cols; col++) cells[col] = grid->blank;
+    mark_dirty(grid, row, 0, grid->cols);
+}
+
+/* ============================================================================
+ * Instance packing
+ * ============================================================================ */
+
+static bool reserve_page_slots(ocfx_grid_t *grid, size_t page) {
+    if (page < grid->page_slots) return true;
+
+    size_t slots = grid->page_slots ? grid->page_slots : 4;
+    while (slots <= page) slots *= 2;
+    uint32_t *page_cells = realloc(grid->page_cells, slots * sizeof(uint32_t));
+    if (!page_cells) return false;
+    memset(page_cells + grid->page_slots, 0, (slots - grid->page_slots) * sizeof(uint32_t));
+    grid->page_cells = page_cells;
+    grid->page_slots = slots;
+    return true;
+}
+
+/* Look a codepoint's glyph up, through the ASCII cache when possible */
+static void resolve_glyph(ocfx_grid_t *grid, uint32_t codepoint, grid_glyph_t *out,
+                          bool *placeholder) {
+    if (codepoint < OCFX_GRID_ASCII && grid->ascii_ready[codepoint]) {
+        *out = grid->ascii[codepoint];
+        return;
+    }
+
+    memset(out, 0, sizeof(*out));
+    bool stand_in;
+    ocfx_glyph_t *glyph = ocfx_font_lookup_glyph(grid->font, codepoint, &stand_in);
+    if (!glyph) return;
+    if (stand_in) {
+        *placeholder = true;
+        return;
+    }
+
+    if (glyph->width > 0 && glyph->height > 0) {
+        out->u = (uint16_t)glyph->atlas_x;
+        out->v = (uint16_t)glyph->atlas_y;
+        out->w = (uint16_t)glyph->width;
+        out->h = (uint16_t)glyph->height;
+        out->ox = (int16_t)lrintf(glyph->bearing_x);
+        out->oy = (int16_t)lrintf((float)grid->ascent - glyph->bearing_y);
+        out->page = (uint16_t)glyph->page;
+    }
+    if (codepoint < OCFX_GRID_ASCII) {
+        grid->ascii[codepoint] = *out;
+        grid->ascii_ready[codepoint] = 1;
+    }
+}
+
+/* Rebuild the instance of cell index; returns false if it drew a placeholder */
+static bool pack_cell(ocfx_grid_t *grid, size_t index) {
+    const ocfx_grid_cell_t *cell = &grid->cells[index];
+    grid_instance_t *inst = &grid->instances[index];
+    bool placeholder = false;
+
+    if (inst->w) grid->page_cells[inst->page]--;
+
+    grid_glyph_t glyph;
+    memset(&glyph, 0, sizeof(glyph));
+    if (cell->codepoint && cell->codepoint != ' ') {
+        resolve_glyph(grid, cell->codepoint, &glyph, &placeholder);
+        if (glyph.w && !reserve_page_slots(grid, glyph.page)) glyph.w = 0;
+    }
+    if (glyph.w) grid->page_cells[glyph.page]++;
+
+    bool inverse = (cell->attrs & OCFX_GRID_INVERSE) != 0;
+    inst->u = glyph.u;
+    inst->v = glyph.v;
+    inst->w = glyph.w;
+    inst->h = glyph.h;
+    inst->ox = glyph.ox;
+    inst->oy = glyph.oy;
+    inst->page = glyph.page;
+    inst->fg = ocfx_atlas_pack_color(inverse ? cell->bg : cell->fg);
+    inst->bg = ocfx_atlas_pack_color(inverse ? cell->fg : cell->bg);
+    inst->attrs = (uint16_t)(cell->attrs & (OCFX_GRID_UNDERLINE | OCFX_GRID_STRIKE));
+    return !placeholder;
+}
+
+/* Forget every packed glyph (the atlas moved them) */
+static void reset_glyphs(ocfx_grid_t *grid, uint32_t generation) {
+    memset(grid->ascii_ready, 0, sizeof(grid->ascii_ready));
+    memset(grid->instances, 0, (size_t)grid->cols * grid->rows * sizeof(grid_instance_t));
+    if (grid->page_cells) memset(grid->page_cells, 0, grid->page_slots * sizeof(uint32_t));
+    grid->generation = generation;
+    mark_all_dirty(grid);
+}
+
+/* Repack the dirty cells and upload them */
+static void update_instances(ocfx_grid_t *grid) {
+    size_t cols = (size_t)grid->cols;
+
+    /* WAIT mode rasterizes everything needed in one batch up front */
+    size_t count = 0;
+    for (int row = 0; row < grid->rows; row++) {
+        for (int col = grid->dirty_lo[row]; col < grid->dirty_hi[row]; col++) {
+            uint32_t codepoint = grid->cells[row * cols + col].codepoint;
+            if (codepoint && codepoint != ' ') grid->scratch[count++] = codepoint;
+        }
+    }
+    ocfx_font_prepare_glyphs(grid->font, grid->scratch, count);
+
+    /* A lookup may evict a page this pass already packed from; the
+     * second pass then repacks every cell against the new layout */
+    for (int attempt = 0; attempt < 2; attempt++) {
+        uint32_t generation = ocfx_atlas_generation(grid->atlas);
+        if (generation != grid->generation) reset_glyphs(grid, generation);
+
+        for (int row = 0; row < grid->rows; row++) {
+            for (int col = grid->dirty_lo[row]; col < grid->dirty_hi[row]; col++) {
+                if (!pack_cell(grid, row * cols + col)) {
+                    grid->retry[row] = 1;
+                    grid->retry_pending = true;
+                }
+            }
+        }
+        if (ocfx_atlas_generation(grid->atlas) == generation) break;
+    }
+
+    /* Mostly dirty: one upload; otherwise only the changed ranges */
+    glBindBuffer(GL_ARRAY_BUFFER, grid->vbo);
+    if (grid->dirty_rows * 2 > grid->rows) {
+        glBufferSubData(GL_ARRAY_BUFFER, 0,
+                        (GLsizeiptr)(cols * grid->rows * sizeof(grid_instance_t)),
+                        grid->instances);
+    } else {
+        for (int row = 0; row < grid->rows; row++) {
+            int lo = grid->dirty_lo[row], hi = grid->dirty_hi[row];
+            if (lo >= hi) continue;
+            size_t first = row * cols + (size_t)lo;
+            glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)(first * sizeof(grid_instance_t)),
+                            (GLsizeiptr)((size_t)(hi - lo) * sizeof(grid_instance_t)),
+                            &grid->instances[first]);
+        }
+    }
+
+    memset(grid->dirty_lo, 0, (size_t)grid->rows * sizeof(int));
+    memset(grid->dirty_hi, 0, (size_t)grid->rows * sizeof(int));
+    grid->dirty_rows = 0;
+}
+
+/* ============================================================================
+ * Storage
+ * ============================================================================ */
+
+typedef struct {
+    ocfx_grid_cell_t *cells;
+    grid_instance_t *instances;
+    uint32_t *scratch;
+    int *dirty_lo, *dirty_hi;
+    uint8_t *retry;
+} grid_storage_t;
+
+static void free_storage(grid_storage_t *s) {
+    free(s->cells);
+    free(s->instances);
+    free(s->scratch);
+    free(s->dirty_lo);
+    free(s->dirty_hi);
+    free(s->retry);
+}
+
+static bool alloc_storage(grid_storage_t *s, int cols, int rows) {
+    size_t cells = (size_t)cols * rows;
+    s->cells = malloc(cells * sizeof(ocfx_grid_cell_t));
+    s->instances = calloc(cells, sizeof(grid_instance_t));
+    s->scratch = malloc(cells * sizeof(uint32_t));
+    s->dirty_lo = calloc((size_t)rows, sizeof(int));
+    s->dirty_hi = calloc((size_t)rows, sizeof(int));
+    s->retry = calloc((size_t)rows, 1);
+    if (!s->cells || !s->instances || !s->scratch || !s->dirty_lo || !s->dirty_hi ||
+        !s->retry) {
+        free_storage(s);
+        return false;
+    }
+    return true;
+}
+
+/* Move new storage (already filled with cells) into the grid */
+static void install_storage(ocfx_grid_t *grid, grid_storage_t *s, int cols, int rows) {
+    grid_storage_t old = {grid->cells, grid->instances, grid->scratch,
+                          grid->dirty_lo, grid->dirty_hi, grid->retry};
+    free_storage(&old);
+
+    grid->cells = s->cells;
+    grid->instances = s->instances;
+    grid->scratch = s->scratch;
+    grid->dirty_lo = s->dirty_lo;
+    grid->dirty_hi = s->dirty_hi;
+    grid->retry = s->retry;
+    grid->cols = cols;
+    grid->rows = rows;
+    grid->top = 0;
+    grid->retry_pending = false;
+
+    glBindBuffer(GL_ARRAY_BUFFER, grid->vbo);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)((size_t)cols * rows * sizeof(grid_instance_t)),
+                 NULL, GL_DYNAMIC_DRAW);
+    reset_glyphs(grid, ocfx_atlas_generation(grid->atlas));
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+ocfx_grid_t* ocfx_grid_create(ocfx_renderer_t *renderer, ocfx_font_t *font, int cols, int rows) {
+    if (!renderer || !font || cols <= 0 || rows <= 0) return NULL;
+
+    ocfx_grid_t *grid = calloc(1, sizeof(ocfx_grid_t));
+    if (!grid) return NULL;
+
+    grid->renderer = renderer;
+    grid->font = font;
+    grid->atlas = ocfx_font_get_atlas(font);
+    grid->ascent = ocfx_font_get_ascent(font);
+    ocfx_text_measure(font, "M", &grid->cell_width, NULL);
+    /* Cells hold phase-0 glyphs: keep every column on the pixel grid even
+     * when a subpixel font measures a fractional advance */
+    grid->cell_width = roundf(grid->cell_width);
+    if (grid->cell_width < 1.0f) grid->cell_width = 1.0f;
+    grid->cell_height = (float)ocfx_font_get_height(font);
+    grid->blank = (ocfx_grid_cell_t){' ', {1.0f, 1.0f, 1.0f, 1.0f}, {0.0f, 0.0f, 0.0f, 0.0f}, 0};
+
+    grid->program = create_grid_program();
+    if (!grid->program) {
+        free(grid);
+        return NULL;
+    }
+    grid->u_resolution = glGetUniformLocation(grid->program, "u_resolution");
+    grid->u_origin = glGetUniformLocation(grid->program, "u_origin");
+    grid->u_cell = glGetUniformLocation(grid->program, "u_cell");
+    grid->u_cols = glGetUniformLocation(grid->program, "u_cols");
+    grid->u_rows = glGetUniformLocation(grid->program, "u_rows");
+    grid->u_top = glGetUniformLocation(grid->program, "u_top");
+    grid->u_pass = glGetUniformLocation(grid->program, "u_pass");
+    grid->u_page = glGetUniformLocation(grid->program, "u_page");
+    grid->u_texture = glGetUniformLocation(grid->program, "u_texture");
+    grid->u_sdf = glGetUniformLocation(grid->program, "u_sdf");
+    grid->u_underline = glGetUniformLocation(grid->program, "u_underline");
+    grid->u_strike = glGetUniformLocation(grid->program, "u_strike");
+
+    /* Instances only: the quad corners come from gl_VertexID */
+    glGenVertexArrays(1, &grid->vao);
+    glGenBuffers(1, &grid->vbo);
+    glBindVertexArray(grid->vao);
+    glBindBuffer(GL_ARRAY_BUFFER, grid->vbo);
+
+    GLsizei stride = sizeof(grid_instance_t);
+    glVertexAttribIPointer(0, 4, GL_UNSIGNED_SHORT, stride,
+                           (void *)offsetof(grid_instance_t, u));
+    glVertexAttribIPointer(1, 2, GL_SHORT, stride, (void *)offsetof(grid_instance_t, ox));
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride,
+                          (void *)offsetof(grid_instance_t, fg));
+    glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride,
+                          (void *)offsetof(grid_instance_t, bg));
+    glVertexAttribIPointer(4, 2, GL_UNSIGNED_SHORT, stride,
+                           (void *)offsetof(grid_instance_t, page));
+    for (GLuint i = 0; i < 5; i++) {
+        glEnableVertexAttribArray(i);
+        glVertexAttribDivisor(i, 1);
+    }
+    glBindVertexArray(0);
+
+    grid_storage_t storage;
+    if (!alloc_storage(&storage, cols, rows)) {
+        ocfx_grid_destroy(grid);
+        return NULL;
+    }
+    for (size_t i = 0; i < (size_t)cols * rows; i++) storage.cells[i] = grid->blank;
+    install_storage(grid, &storage, cols, rows);
+
+    return grid;
+}
+
+void ocfx_grid_destroy(ocfx_grid_t *grid) {
+    if (!grid) return;
+
+    grid_storage_t storage = {grid->cells, grid->instances, grid->scratch,
+                              grid->dirty_lo, grid->dirty_hi, grid->retry};
+    free_storage(&storage);
+    free(grid->page_cells);
+
+    if (grid->vbo) glDeleteBuffers(1, &grid->vbo);
+    if (grid->vao) glDeleteVertexArrays(1, &grid->vao);
+    if (grid->program) glDeleteProgram(grid->program);
+    free(grid);
+}
+
+bool ocfx_grid_resize(ocfx_grid_t *grid, int cols, int rows) {
+    if (!grid || cols <= 0 || rows <= 0) return false;
+    if (cols == grid->cols && rows == grid->rows) return true;
+
+    grid_storage_t storage;
+    if (!alloc_storage(&storage, cols, rows)) return false;
+
+    for (int row = 0; row < rows; row++) {
+        ocfx_grid_cell_t *dst = &storage.cells[(size_t)row * cols];
+        int keep = 0;
+        if (row < grid->rows) {
+            keep = cols < grid->cols ? cols : grid->cols;
+            memcpy(dst, &grid->cells[(size_t)physical_row(grid, row) * grid->cols],
+                   (size_t)keep * sizeof(ocfx_grid_cell_t));
+        }
+        for (int col = keep; col < cols; col++) dst[col] = grid->blank;
+    }
+    install_storage(grid, &storage, cols, rows);
+    return true;
+}
+
+void ocfx_grid_get_size(ocfx_grid_t *grid, int *cols, int *rows) {
+    if (cols) *cols = grid ? grid->cols : 0;
+    if (rows) *rows = grid ? grid->rows : 0;
+}
+
+void ocfx_grid_get_cell_size(ocfx_grid_t *grid, float *width, float *height) {
+    if (width) *width = grid ? grid->cell_width : 0.0f;
+    if (height) *height = grid ? grid->cell_height : 0.0f;
+}
+
+void ocfx_grid_set_cell(ocfx_grid_t *grid, int col, int row, const ocfx_grid_cell_t *cell) {
+    if (!grid || !cell || col < 0 || row < 0 || col >= grid->cols || row >= grid->rows) return;
+
+    int phys = physical_row(grid, row);
+    ocfx_grid_cell_t *dst = &grid->cells[(size_t)phys * grid->cols + col];
+    if (memcmp(dst, cell, sizeof(*dst)) == 0) return;
+
+    *dst = *cell;
+    mark_dirty(grid, phys, col, col + 1);
+}
+
+const ocfx_grid_cell_t* ocfx_grid_get_cell(ocfx_grid_t *grid, int col, int row) {
+    if (!grid || col < 0 || row < 0 || col >= grid->cols || row >= grid->rows) return NULL;
+    return &grid->cells[(size_t)physical_row(grid, row) * grid->cols + col];
+}
+
+int ocfx_grid_write(ocfx_grid_t *grid, int col, int row, const char *text,
+                    ocfx_color_t fg, ocfx_color_t bg, uint32_t attrs) {
+    if (!grid || !text || col < 0 || row < 0 || row >= grid->rows) return 0;
+
+    const char *end = text + strlen(text);
+    uint32_t codepoints[64];
+    ocfx_grid_cell_t cell = {0, fg, bg, attrs};
+    int written = 0;
+    size_t n;
+
+    while (col < grid->cols && (n = ocfx_utf8_decode(&text, end, codepoints, 64)) > 0) {
+        for (size_t i = 0; i < n && col < grid->cols; i++) {
+            cell.codepoint = codepoints[i];
+            ocfx_grid_set_cell(grid, col++, row, &cell);
+            written++;
+        }
+    }
+    return written;
+}
+
+void ocfx_grid_clear(ocfx_grid_t *grid, ocfx_color_t fg, ocfx_color_t bg) {
+    if (!grid) return;
+
+    grid->blank.fg = fg;
+    grid->blank.bg = bg;
+    for (int row = 0; row < grid->rows; row++) fill_row(grid, row);
+}
+
+void ocfx_grid_scroll(ocfx_grid_t *grid, int lines) {
+    if (!grid || lines == 0) return;
+
+    int n = lines > 0 ? lines : -lines;
+    if (n >= grid->rows) {
+        for (int row = 0; row < grid->rows; row++) fill_row(grid, row);
+        return;
+    }
+
+    /* The rows that wrap around come back in as the new blank ones */
+    if (lines > 0) {
+        grid->top = (grid->top + n) % grid->rows;
+        for (int row = grid->rows - n; row < grid->rows; row++) {
+            fill_row(grid, physical_row(grid, row));
+        }
+    } else {
+        grid->top = (grid->top - n + grid->rows) % grid->rows;
+        for (int row = 0; row < n; row++) fill_row(grid, physical_row(grid, row));
+    }
+}
+
+void ocfx_grid_draw(ocfx_grid_t *grid, float x, float y) {
+    if (!grid) return;
+
+    /* Queued text goes first so draw order matches call order */
+    ocfx_atlas_flush(grid->atlas);
+
+    /* Keep our pages fresh before lookups can evict anything */
+    for (size_t page = 0; page < grid->page_slots; page++) {
+        if (grid->page_cells[page]) ocfx_atlas_touch_page(grid->atlas, (uint32_t)page);
+    }
+
+    /* Rows that drew placeholders try again, and an atlas that dropped
+     * glyphs invalidates every packed rectangle */
+    if (grid->retry_pending) {
+        for (int row = 0; row < grid->rows; row++) {
+            if (!grid->retry[row]) continue;
+            grid->retry[row] = 0;
+            mark_dirty(grid, row, 0, grid->cols);
+        }
+        grid->retry_pending = false;
+    }
+    if (ocfx_atlas_generation(grid->atlas) != grid->generation) {
+        reset_glyphs(grid, ocfx_atlas_generation(grid->atlas));
+    }
+    if (grid->dirty_rows) update_instances(grid);
+
+    int32_t vp_width, vp_height;
+    ocfx_render_get_viewport(grid->renderer, &vp_width, &vp_height);
+
+    float thickness = fmaxf(1.0f, roundf(grid->cell_height / 16.0f));
+    float underline = fminf((float)grid->ascent + 1.0f, grid->cell_height - thickness);
+    GLsizei cells = (GLsizei)((size_t)grid->cols * grid->rows);
+
+    glUseProgram(grid->program);
+    glUniform2f(grid->u_resolution, (float)vp_width, (float)vp_height);
+    glUniform2f(grid->u_origin, x, y);
+    glUniform2f(grid->u_cell, grid->cell_width, grid->cell_height);
+    glUniform1i(grid->u_cols, grid->cols);
+    glUniform1i(grid->u_rows, grid->rows);
+    glUniform1i(grid->u_top, grid->top);
+    glUniform1i(grid->u_texture, 0);
+    glUniform1i(grid->u_sdf, ocfx_font_is_sdf(grid->font) ? 1 : 0);
+    glUniform2f(grid->u_underline, underline, thickness);
+    glUniform1f(grid->u_strike, floorf((float)grid->ascent * 0.7f));
+    glBindVertexArray(grid->vao);
+
+    /* Backgrounds (with underline and strike bands) */
+    glUniform1i(grid->u_pass, 0);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, cells);
+
+    /* Glyphs, one pass per page in use */
+    glUniform1i(grid->u_pass, 1);
+    for (size_t page = 0; page < grid->page_slots; page++) {
+        if (!grid->page_cells[page]) continue;
+        ocfx_atlas_touch_page(grid->atlas, (uint32_t)page);
+        ocfx_atlas_bind_page(grid->atlas, (uint32_t)page);
+        glUniform1ui(grid->u_page, (GLuint)page);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, cells);
+    }
+
+    glBindVertexArray(0);
+}
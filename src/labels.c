@@ -0,0 +1,318 @@
+/* OCFX - Label Layer Implementation
+ * Candidates are measured once when added. Placement sorts them by
+ * priority and tests each box only against the labels already placed in
+ * the grid cells it covers, then inserts it into those cells.
+ */
+
+#include "ocfx/labels.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#ifndef OCFX_LABEL_CELL
+#define OCFX_LABEL_CELL 64.0f            /* Grid cell size in pixels */
+#endif
+
+#ifndef OCFX_LABEL_MAX_CELLS
+#define OCFX_LABEL_MAX_CELLS (1u << 16)  /* Larger viewports get coarser cells */
+#endif
+
+#define LABEL_NONE UINT32_MAX
+
+typedef struct {
+    size_t text;                  /* Offset into the layer's text store */
+    size_t len;
+    float x0, y0, x1, y1;         /* Box, without padding */
+    float priority;
+    ocfx_color_t color;
+    bool placed;
+} label_t;
+
+/* Placement order entry */
+typedef struct {
+    float priority;
+    uint32_t index;
+} label_order_t;
+
+/* Entry in a grid cell's list of placed labels */
+typedef struct {
+    uint32_t label;
+    uint32_t next;
+} label_node_t;
+
+/* Label layer structure (opaque to users) */
+struct ocfx_label_layer_t {
+    ocfx_font_t *font;
+    float padding;
+
+    label_t *labels;
+    size_t count;
+    size_t capacity;
+
+    char *chars;
+    size_t chars_len;
+    size_t chars_capacity;
+
+    /* Labels by priority, re-sorted only after adds, so placing the same
+     * candidates in a panned viewport skips the sort */
+    label_order_t *order;
+    size_t order_capacity;
+    bool sorted;
+
+    /* Placement scratch, kept between frames */
+    uint32_t *cells;              /* First node per cell */
+    size_t cell_capacity;
+    label_node_t *nodes;
+    size_t node_count;
+    size_t node_capacity;
+
+    uint32_t *placed;             /* Placed labels, in placement order */
+    size_t placed_count;
+    size_t placed_capacity;
+};
+
+/* ============================================================================
+ * Storage
+ * ============================================================================ */
+
+/* Make room for need elements of size bytes in *array */
+static bool reserve(void **array, size_t *capacity, size_t need, size_t size) {
+    if (need <= *capacity) return true;
+    size_t cap = *capacity ? *capacity : 64;
+    while (cap < need) cap *= 2;
+    void *grown = realloc(*array, cap * size);
+    if (!grown) return false;
+    *array = grown;
+    *capacity = cap;
+    return true;
+}
+
+/* ============================================================================
+ * Placement
+ * ============================================================================ */
+
+static int compare_order(const void *a, const void *b) {
+    const label_order_t *x = a, *y = b;
+    if (x->priority != y->priority) return x->priority > y->priority ? -1 : 1;
+    return x->index < y->index ? -1 : x->index > y->index;
+}
+
+/* Grid over the viewport: cell size and dimensions */
+typedef struct {
+    float x, y;
+    float cell;
+    int cols, rows;
+} label_grid_t;
+
+static void cell_range(const label_grid_t *grid, float x0, float y0, float x1, float y1,
+                       int *c0, int *r0, int *c1, int *r1) {
+    *c0 = (int)floorf((x0 - grid->x) / grid->cell);
+    *r0 = (int)floorf((y0 - grid->y) / grid->cell);
+    *c1 = (int)floorf((x1 - grid->x) / grid->cell);
+    *r1 = (int)floorf((y1 - grid->y) / grid->cell);
+    if (*c0 < 0) *c0 = 0;
+    if (*r0 < 0) *r0 = 0;
+    if (*c1 >= grid->cols) *c1 = grid->cols - 1;
+    if (*r1 >= grid->rows) *r1 = grid->rows - 1;
+}
+
+/* Does the padded box overlap any label placed in its cells? */
+static bool collides(ocfx_label_layer_t *layer, const label_grid_t *grid,
+                     float x0, float y0, float x1, float y1) {
+    /* Labels are filed under their unpadded boxes: widen the search */
+    float pad = layer->padding;
+    int c0, r0, c1, r1;
+    cell_range(grid, x0 - pad, y0 - pad, x1 + pad, y1 + pad, &c0, &r0, &c1, &r1);
+
+    for (int r = r0; r <= r1; r++) {
+        for (int c = c0; c <= c1; c++) {
+            uint32_t node = layer->cells[(size_t)r * grid->cols + c];
+            while (node != LABEL_NONE) {
+                const label_t *other = &layer->labels[layer->nodes[node].label];
+                if (x0 < other->x1 + pad && other->x0 - pad < x1 &&
+                    y0 < other->y1 + pad && other->y0 - pad < y1) {
+                    return true;
+                }
+                node = layer->nodes[node].next;
+            }
+        }
+    }
+    return false;
+}
+
+static bool insert(ocfx_label_layer_t *layer, const label_grid_t *grid, uint32_t index) {
+    const label_t *label = &layer->labels[index];
+    int c0, r0, c1, r1;
+    cell_range(grid, label->x0, label->y0, label->x1, label->y1, &c0, &r0, &c1, &r1);
+
+    size_t cells = (size_t)(c1 - c0 + 1) * (size_t)(r1 - r0 + 1);
+    if (!reserve((void **)&layer->nodes, &layer->node_capacity,
+                 layer->node_count + cells, sizeof(label_node_t))) {
+        return false;
+    }
+
+    for (int r = r0; r <= r1; r++) {
+        for (int c = c0; c <= c1; c++) {
+            uint32_t *head = &layer->cells[(size_t)r * grid->cols + c];
+            layer->nodes[layer->node_count] = (label_node_t){index, *head};
+            *head = (uint32_t)layer->node_count++;
+        }
+    }
+    return true;
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+ocfx_label_layer_t* ocfx_label_layer_create(ocfx_font_t *font) {
+    if (!font) return NULL;
+
+    ocfx_label_layer_t *layer = calloc(1, sizeof(ocfx_label_layer_t));
+    if (!layer) return NULL;
+    layer->font = font;
+    layer->padding = 2.0f;
+    return layer;
+}
+
+void ocfx_label_layer_destroy(ocfx_label_layer_t *layer) {
+    if (!layer) return;
+    free(layer->labels);
+    free(layer->chars);
+    free(layer->order);
+    free(layer->cells);
+    free(layer->nodes);
+    free(layer->placed);
+    free(layer);
+}
+
+void ocfx_label_layer_clear(ocfx_label_layer_t *layer) {
+    if (!layer) return;
+    layer->count = 0;
+    layer->chars_len = 0;
+    layer->sorted = false;
+    layer->placed_count = 0;
+}
+
+void ocfx_label_layer_set_padding(ocfx_label_layer_t *layer, float padding) {
+    if (layer) layer->padding = padding > 0.0f ? padding : 0.0f;
+}
+
+size_t ocfx_label_layer_add(ocfx_label_layer_t *layer, const char *text, size_t len,
+                            float x, float y, ocfx_text_align_t align,
+                            float priority, ocfx_color_t color) {
+    if (!layer || (!text && len > 0) || layer->count >= LABEL_NONE) return SIZE_MAX;
+
+    if (!reserve((void **)&layer->labels, &layer->capacity, layer->count + 1,
+                 sizeof(label_t)) ||
+        !reserve((void **)&layer->chars, &layer->chars_capacity,
+                 layer->chars_len + len, 1)) {
+        fprintf(stderr, "OCFX: Out of memory adding label\n");
+        return SIZE_MAX;
+    }
+
+    if (len > 0) memcpy(layer->chars + layer->chars_len, text, len);
+
+    float width;
+    ocfx_text_measure_n(layer->font, text, len, &width, NULL);
+    float height = (float)ocfx_font_get_height(layer->font);
+
+    float x0 = x;
+    if (align == OCFX_TEXT_ALIGN_CENTER) x0 -= width * 0.5f;
+    else if (align == OCFX_TEXT_ALIGN_RIGHT) x0 -= width;
+    float y0 = y - height * 0.5f;
+
+    label_t *label = &layer->labels[layer->count];
+    *label = (label_t){
+        .text = layer->chars_len,
+        .len = len,
+        .x0 = x0, .y0 = y0,
+        .x1 = x0 + width, .y1 = y0 + height,
+        .priority = priority,
+        .color = color,
+    };
+    layer->chars_len += len;
+    layer->sorted = false;
+    return layer->count++;
+}
+
+size_t ocfx_label_layer_place(ocfx_label_layer_t *layer, ocfx_rect_t viewport) {
+    if (!layer) return 0;
+    layer->placed_count = 0;
+    layer->node_count = 0;
+    for (size_t i = 0; i < layer->count; i++) layer->labels[i].placed = false;
+    if (layer->count == 0 || viewport.width <= 0.0f || viewport.height <= 0.0f) return 0;
+
+    /* Grid over the viewport, coarsened until it fits the cell budget */
+    label_grid_t grid = {viewport.x, viewport.y, OCFX_LABEL_CELL, 0, 0};
+    for (;;) {
+        grid.cols = (int)ceilf(viewport.width / grid.cell);
+        grid.rows = (int)ceilf(viewport.height / grid.cell);
+        if ((size_t)grid.cols * (size_t)grid.rows <= OCFX_LABEL_MAX_CELLS) break;
+        grid.cell *= 2.0f;
+    }
+    size_t cells = (size_t)grid.cols * (size_t)grid.rows;
+
+    if (!reserve((void **)&layer->cells, &layer->cell_capacity, cells, sizeof(uint32_t)) ||
+        !reserve((void **)&layer->order, &layer->order_capacity, layer->count,
+                 sizeof(label_order_t)) ||
+        !reserve((void **)&layer->placed, &layer->placed_capacity, layer->count,
+                 sizeof(uint32_t))) {
+        fprintf(stderr, "OCFX: Out of memory placing labels\n");
+        return 0;
+    }
+    memset(layer->cells, 0xFF, cells * sizeof(uint32_t));
+
+    if (!layer->sorted) {
+        for (size_t i = 0; i < layer->count; i++) {
+            layer->order[i] = (label_order_t){layer->labels[i].priority, (uint32_t)i};
+        }
+        qsort(layer->order, layer->count, sizeof(label_order_t), compare_order);
+        layer->sorted = true;
+    }
+
+    /* Highest priority first; labels wholly outside the viewport are skipped */
+    float vx1 = viewport.x + viewport.width;
+    float vy1 = viewport.y + viewport.height;
+    for (size_t i = 0; i < layer->count; i++) {
+        uint32_t index = layer->order[i].index;
+        label_t *label = &layer->labels[index];
+        if (label->x1 <= viewport.x || label->x0 >= vx1 ||
+            label->y1 <= viewport.y || label->y0 >= vy1) continue;
+        if (collides(layer, &grid, label->x0, label->y0, label->x1, label->y1)) continue;
+        if (!insert(layer, &grid, index)) {
+            fprintf(stderr, "OCFX: Out of memory placing labels\n");
+            break;
+        }
+        label->placed = true;
+        layer->placed[layer->placed_count++] = index;
+    }
+    return layer->placed_count;
+}
+
+size_t ocfx_label_layer_count(ocfx_label_layer_t *layer) {
+    return layer ? layer->count : 0;
+}
+
+bool ocfx_label_layer_is_placed(ocfx_label_layer_t *layer, size_t index) {
+    return layer && index < layer->count && layer->labels[index].placed;
+}
+
+ocfx_rect_t ocfx_label_layer_get_bounds(ocfx_label_layer_t *layer, size_t index) {
+    if (!layer || index >= layer->count) return (ocfx_rect_t){0, 0, 0, 0};
+    const label_t *label = &layer->labels[index];
+    return (ocfx_rect_t){label->x0, label->y0, label->x1 - label->x0, label->y1 - label->y0};
+}
+
+void ocfx_label_layer_draw(ocfx_renderer_t *renderer, ocfx_label_layer_t *layer) {
+    if (!renderer || !layer) return;
+
+    /* Survivors only, all into the same batch */
+    for (size_t i = 0; i < layer->placed_count; i++) {
+        const label_t *label = &layer->labels[layer->placed[i]];
+        ocfx_text_draw_n(renderer, layer->font, layer->chars + label->text, label->len,
+                         label->x0, label->y0, label->color);
+    }
+}
@@ -0,0 +1,379 @@
+/* OCFX - Background Glyph Rasterizer Implementation
+ * Two FIFOs of glyph jobs, draw misses ahead of background work, served
+ * by a fixed set of pthreads. Each worker keeps the last face it opened,
+ * so a face is parsed once per worker rather than once per batch;
+ * finished bitmaps wait in a result list for the render thread.
+ */
+
+#define _POSIX_C_SOURCE 200809L  /* For pthreads */
+
+#include "raster.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_OUTLINE_H
+
+/* FreeType renders signed distance fields natively since 2.11 */
+#if FREETYPE_MAJOR > 2 || (FREETYPE_MAJOR == 2 && FREETYPE_MINOR >= 11)
+#define OCFX_HAVE_FT_SDF 1
+#endif
+
+#define RASTER_MODE_SDF 1             /* OCFX_ATLAS_MODE_SDF */
+
+/* Growable job list */
+typedef struct {
+    ocfx_raster_job_t *jobs;
+    size_t head;                  /* First live job (queue only) */
+    size_t count;                 /* One past the last live job */
+    size_t capacity;
+} job_list_t;
+
+/* Pool state (process-wide) */
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work_ready = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t work_done = PTHREAD_COND_INITIALIZER;
+static pthread_t threads[OCFX_RASTER_MAX_WORKERS];
+static void *running_owner[OCFX_RASTER_MAX_WORKERS];
+static bool running_urgent[OCFX_RASTER_MAX_WORKERS];  /* Batch came from the urgent queue */
+static uint32_t open_face[OCFX_RASTER_MAX_WORKERS];  /* Face id a worker has open, 0 = none */
+static bool drop_face[OCFX_RASTER_MAX_WORKERS];      /* Close it (set by cancel) */
+static int worker_count;
+static bool stopping;
+static uint32_t generation;
+static job_list_t urgent;            /* Glyphs a draw is missing, served first */
+static job_list_t queue;             /* Background work (prewarm) */
+static job_list_t results;
+
+static bool list_push(job_list_t *list, const ocfx_raster_job_t *job) {
+    if (list->count >= list->capacity) {
+        /* Reclaim consumed slots before growing */
+        if (list->head > 0) {
+            memmove(list->jobs, list->jobs + list->head,
+                    (list->count - list->head) * sizeof(ocfx_raster_job_t));
+            list->count -= list->head;
+            list->head = 0;
+        }
+        if (list->count >= list->capacity) {
+            size_t new_cap = list->capacity ? list->capacity * 2 : 256;
+            ocfx_raster_job_t *jobs = realloc(list->jobs, new_cap * sizeof(ocfx_raster_job_t));
+            if (!jobs) return false;
+            list->jobs = jobs;
+            list->capacity = new_cap;
+        }
+    }
+    list->jobs[list->count++] = *job;
+    return true;
+}
+
+/* Remove every job of owner, freeing result bitmaps */
+static void list_drop_owner(job_list_t *list, void *owner) {
+    size_t out = list->head;
+    for (size_t i = list->head; i < list->count; i++) {
+        if (list->jobs[i].owner == owner) {
+            free(list->jobs[i].bitmap);
+        } else {
+            list->jobs[out++] = list->jobs[i];
+        }
+    }
+    list->count = out;
+}
+
+static void list_free(job_list_t *list) {
+    for (size_t i = list->head; i < list->count; i++) {
+        free(list->jobs[i].bitmap);
+    }
+    free(list->jobs);
+    memset(list, 0, sizeof(*list));
+}
+
+/* Render one glyph into job's result fields (no lock held) */
+static void rasterize(FT_Face face, ocfx_raster_job_t *job) {
+    job->ok = false;
+
+    if (job->mode == RASTER_MODE_SDF) {
+#ifdef OCFX_HAVE_FT_SDF
+        if (FT_Load_Glyph(face, job->glyph_index, FT_LOAD_DEFAULT) ||
+            FT_Render_Glyph(face->glyph, FT_RENDER_MODE_SDF)) {
+            return;
+        }
+#else
+        return;
+#endif
+    } else if (job->subpixel) {
+        /* Shift the outline by the phase before rendering */
+        if (FT_Load_Glyph(face, job->glyph_index, FT_LOAD_TARGET_LIGHT)) return;
+        if (face->glyph->format == FT_GLYPH_FORMAT_OUTLINE) {
+            FT_Outline_Translate(&face->glyph->outline, job->x_offset, 0);
+        }
+        if (FT_Render_Glyph(face->glyph, FT_RENDER_MODE_NORMAL)) return;
+    } else if (FT_Load_Glyph(face, job->glyph_index, FT_LOAD_RENDER)) {
+        return;
+    }
+
+    FT_GlyphSlot slot = face->glyph;
+    int width = (int)slot->bitmap.width;
+    int height = (int)slot->bitmap.rows;
+    if (width > 0 && height > 0) {
+        job->bitmap = malloc((size_t)width * height);
+        if (!job->bitmap) return;
+        for (int row = 0; row < height; row++) {
+            memcpy(job->bitmap + (size_t)row * width,
+                   slot->bitmap.buffer + (ptrdiff_t)row * slot->bitmap.pitch, (size_t)width);
+        }
+    }
+
+    job->width = width;
+    job->height = height;
+    job->bearing_x = (float)slot->bitmap_left;
+    job->bearing_y = (float)slot->bitmap_top;
+    job->advance = job->subpixel ? (float)slot->linearHoriAdvance / 65536.0f :
+                                   (float)(slot->advance.x >> 6);
+    job->ok = true;
+}
+
+static void* worker_main(void *arg) {
+    int id = (int)(intptr_t)arg;
+    ocfx_raster_job_t batch[OCFX_RASTER_BATCH];
+
+    FT_Library library;
+    if (FT_Init_FreeType(&library)) {
+        fprintf(stderr, "OCFX: Raster worker failed to initialize FreeType\n");
+        library = NULL;
+    }
+
+    /* Open face, kept across batches; only this thread touches it */
+    FT_Face face = NULL;
+    int face_size = 0;
+
+    pthread_mutex_lock(&pool_lock);
+    for (;;) {
+        while (!stopping && urgent.head == urgent.count && queue.head == queue.count &&
+               !drop_face[id]) {
+            pthread_cond_wait(&work_ready, &pool_lock);
+        }
+
+        /* Its mapping is about to go away: close it before cancel returns */
+        if (drop_face[id]) {
+            if (face) FT_Done_Face(face);
+            face = NULL;
+            open_face[id] = 0;
+            drop_face[id] = false;
+            pthread_cond_broadcast(&work_done);
+        }
+        if (stopping) break;
+
+        /* Take a run of jobs sharing the first job's owner and face, from
+         * the urgent queue while it has any */
+        job_list_t *src = urgent.head < urgent.count ? &urgent : &queue;
+        if (src->head == src->count) continue;
+        size_t n = 0;
+        size_t limit = src == &urgent ? OCFX_RASTER_BATCH : OCFX_RASTER_BACKGROUND_BATCH;
+        void *owner = src->jobs[src->head].owner;
+        uint32_t face_id = src->jobs[src->head].face_id;
+        while (n < limit && src->head < src->count &&
+               src->jobs[src->head].owner == owner &&
+               src->jobs[src->head].face_id == face_id) {
+            batch[n++] = src->jobs[src->head++];
+        }
+        running_owner[id] = owner;
+        running_urgent[id] = src == &urgent;
+        bool reopen = !face || open_face[id] != face_id;
+        open_face[id] = face_id;
+        pthread_mutex_unlock(&pool_lock);
+
+        if (reopen && library) {
+            if (face) FT_Done_Face(face);
+            face = NULL;
+            face_size = 0;
+            if (FT_New_Memory_Face(library, batch[0].data, (FT_Long)batch[0].data_size,
+                                   0, &face)) {
+                face = NULL;
+            }
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            if (!face) {
+                batch[i].ok = false;
+                continue;
+            }
+            if (batch[i].size != face_size) {
+                face_size = batch[i].size;
+                FT_Set_Pixel_Sizes(face, 0, (FT_UInt)face_size);
+            }
+            rasterize(face, &batch[i]);
+        }
+
+        pthread_mutex_lock(&pool_lock);
+        for (size_t i = 0; i < n; i++) {
+            if (!list_push(&results, &batch[i])) free(batch[i].bitmap);
+        }
+        running_owner[id] = NULL;
+        pthread_cond_broadcast(&work_done);
+    }
+    open_face[id] = 0;
+    drop_face[id] = false;
+    pthread_mutex_unlock(&pool_lock);
+
+    if (face) FT_Done_Face(face);
+    if (library) FT_Done_FreeType(library);
+    return NULL;
+}
+
+static bool list_has_owner(const job_list_t *list, void *owner) {
+    for (size_t i = list->head; i < list->count; i++) {
+        if (list->jobs[i].owner == owner) return true;
+    }
+    return false;
+}
+
+/* Is any job of owner queued or being rasterized? Only urgent ones when
+ * urgent_only is set. (lock held) */
+static bool owner_busy(void *owner, bool urgent_only) {
+    for (int i = 0; i < worker_count; i++) {
+        if (running_owner[i] == owner && (running_urgent[i] || !urgent_only)) return true;
+    }
+    return list_has_owner(&urgent, owner) || (!urgent_only && list_has_owner(&queue, owner));
+}
+
+/* ============================================================================
+ * Internal API
+ * ============================================================================ */
+
+bool ocfx_raster_start(int workers) {
+    ocfx_raster_stop();
+    if (workers <= 0) return true;
+    if (workers > OCFX_RASTER_MAX_WORKERS) workers = OCFX_RASTER_MAX_WORKERS;
+
+    pthread_mutex_lock(&pool_lock);
+    stopping = false;
+    pthread_mutex_unlock(&pool_lock);
+
+    for (int i = 0; i < workers; i++) {
+        if (pthread_create(&threads[i], NULL, worker_main, (void*)(intptr_t)i) != 0) {
+            fprintf(stderr, "OCFX: Failed to start raster worker %d\n", i);
+            break;
+        }
+        worker_count++;
+    }
+    generation++;
+    return worker_count > 0;
+}
+
+void ocfx_raster_stop(void) {
+    if (worker_count == 0) return;
+
+    pthread_mutex_lock(&pool_lock);
+    stopping = true;
+    pthread_cond_broadcast(&work_ready);
+    pthread_mutex_unlock(&pool_lock);
+
+    for (int i = 0; i < worker_count; i++) {
+        pthread_join(threads[i], NULL);
+        running_owner[i] = NULL;
+    }
+    worker_count = 0;
+
+    /* Unfinished work is dropped; owners resubmit what they still need */
+    list_free(&urgent);
+    list_free(&queue);
+    list_free(&results);
+    generation++;
+}
+
+bool ocfx_raster_running(void) {
+    return worker_count > 0;
+}
+
+uint32_t ocfx_raster_generation(void) {
+    return generation;
+}
+
+bool ocfx_raster_submit(const ocfx_raster_job_t *job) {
+    if (worker_count == 0) return false;
+
+    ocfx_raster_job_t entry = *job;
+    entry.ok = false;
+    entry.bitmap = NULL;
+
+    pthread_mutex_lock(&pool_lock);
+    bool ok = list_push(job->urgent ? &urgent : &queue, &entry);
+    if (ok) pthread_cond_signal(&work_ready);
+    pthread_mutex_unlock(&pool_lock);
+    return ok;
+}
+
+size_t ocfx_raster_collect(ocfx_raster_job_t *out, size_t max) {
+    if (worker_count == 0) return 0;
+
+    pthread_mutex_lock(&pool_lock);
+    size_t n = results.count - results.head;
+    if (n > max) n = max;
+    if (n) memcpy(out, results.jobs + results.head, n * sizeof(ocfx_raster_job_t));
+    results.head += n;
+    if (results.head == results.count) results.head = results.count = 0;
+    pthread_mutex_unlock(&pool_lock);
+    return n;
+}
+
+void ocfx_raster_promote(void *owner, uint64_t key) {
+    if (worker_count == 0) return;
+
+    pthread_mutex_lock(&pool_lock);
+    for (size_t i = queue.head; i < queue.count; i++) {
+        ocfx_raster_job_t *job = &queue.jobs[i];
+        if (job->owner != owner || job->key != key) continue;
+
+        ocfx_raster_job_t entry = *job;
+        entry.urgent = true;
+        if (list_push(&urgent, &entry)) {
+            memmove(job, job + 1, (queue.count - i - 1) * sizeof(ocfx_raster_job_t));
+            queue.count--;
+        }
+        break;
+    }
+    pthread_mutex_unlock(&pool_lock);
+}
+
+void ocfx_raster_wait_urgent(void *owner) {
+    if (worker_count == 0) return;
+
+    pthread_mutex_lock(&pool_lock);
+    while (owner_busy(owner, true)) {
+        pthread_cond_wait(&work_done, &pool_lock);
+    }
+    pthread_mutex_unlock(&pool_lock);
+}
+
+/* Is any worker still to close its handle on a dropped face? (lock held) */
+static bool faces_dropping(void) {
+    for (int i = 0; i < worker_count; i++) {
+        if (drop_face[i]) return true;
+    }
+    return false;
+}
+
+void ocfx_raster_cancel(void *owner, uint32_t face_id) {
+    if (worker_count == 0) return;
+
+    pthread_mutex_lock(&pool_lock);
+    list_drop_owner(&urgent, owner);
+    list_drop_owner(&queue, owner);
+    while (owner_busy(owner, false)) {
+        pthread_cond_wait(&work_done, &pool_lock);
+    }
+    list_drop_owner(&results, owner);
+
+    /* Workers reopen the face if another font still uses it */
+    bool dropping = false;
+    for (int i = 0; i < worker_count; i++) {
+        if (open_face[i] == face_id) drop_face[i] = dropping = true;
+    }
+    if (dropping) {
+        pthread_cond_broadcast(&work_ready);
+        while (faces_dropping()) pthread_cond_wait(&work_done, &pool_lock);
+    }
+    pthread_mutex_unlock(&pool_lock);
+}
@@ -0,0 +1,67 @@
+/* OCFX - Background Glyph Rasterizer (internal)
+ * Worker threads that render glyph bitmaps off the render thread. Each
+ * worker has its own FT_Library and keeps its own FT_Face open on the
+ * shared font mapping; only the atlas upload happens on the render thread.
+ */
+
+#ifndef OCFX_RASTER_H
+#define OCFX_RASTER_H
+
+#include "ocfx/types.h"
+
+#ifndef OCFX_RASTER_MAX_WORKERS
+#define OCFX_RASTER_MAX_WORKERS 16
+#endif
+
+#ifndef OCFX_RASTER_BATCH
+#define OCFX_RASTER_BATCH 64          /* Jobs of one owner taken at a time */
+#endif
+
+/* Background jobs taken at a time: one, so a worker checks the urgent
+ * queue after every glyph (and cancel does not wait on a long run) */
+#ifndef OCFX_RASTER_BACKGROUND_BATCH
+#define OCFX_RASTER_BACKGROUND_BATCH 1
+#endif
+
+/* Glyph job. The render thread fills the request, a worker the result. */
+typedef struct {
+    /* Request */
+    void *owner;                  /* Font; results are matched back by it */
+    uint32_t face_id;             /* Registry id: workers keep one face open per id */
+    const uint8_t *data;          /* Font file mapping (outlives the job) */
+    size_t data_size;
+    int size;                     /* Pixel size */
+    uint32_t mode;                /* ocfx_atlas_mode_t */
+    uint32_t glyph_index;
+    uint64_t key;
+    bool subpixel;                /* Light hinting, unrounded advance */
+    int x_offset;                 /* Subpixel shift in 1/64 pixel */
+    bool urgent;                  /* Needed by a draw: ahead of background work */
+
+    /* Result (bitmap is malloc'd, tightly packed, owned by the collector) */
+    bool ok;
+    uint8_t *bitmap;
+    int width, height;
+    float bearing_x, bearing_y;
+    float advance;
+} ocfx_raster_job_t;
+
+/* Pool (process-wide, controlled from the render thread) */
+bool ocfx_raster_start(int workers);
+void ocfx_raster_stop(void);
+bool ocfx_raster_running(void);
+uint32_t ocfx_raster_generation(void);    /* Changes on every start/stop */
+
+/* Jobs */
+bool ocfx_raster_submit(const ocfx_raster_job_t *job);
+size_t ocfx_raster_collect(ocfx_raster_job_t *out, size_t max);
+/* Move a queued background job of owner to the urgent queue */
+void ocfx_raster_promote(void *owner, uint64_t key);
+/* Until no urgent job of owner is queued or running; background work such
+ * as prewarm is not waited for */
+void ocfx_raster_wait_urgent(void *owner);
+/* Drop all jobs and results of owner, and close the workers' handles on
+ * face_id, whose mapping the caller may release after this returns */
+void ocfx_raster_cancel(void *owner, uint32_t face_id);
+
+#endif /* OCFX_RASTER_H */
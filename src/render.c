@@ -4,6 +4,7 @@
 
 #include "ocfx/render.h"
 #include "ocfx/wayland.h"
+#include "atlas.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -29,9 +30,15 @@ struct ocfx_renderer_t {
     GLuint vao;
     GLuint vbo;
 
+    /* Glyph atlas and text batch shared by all fonts */
+    ocfx_atlas_t *atlas;
+
     /* Viewport */
     int32_t viewport_width;
     int32_t viewport_height;
+
+    /* Frame counter (stamped onto cached resources for LRU decisions) */
+    uint64_t frame;
 };
 
 /* Basic vertex shader */
@@ -105,6 +112,12 @@ static GLuint create_shader_program(const char *vert_src, const char *frag_src)
     return program;
 }
 
+/* Submit queued text before anything else touches the GPU, so draw order
+ * matches call order */
+static inline void flush_text(ocfx_renderer_t *renderer) {
+    if (renderer->atlas) ocfx_atlas_flush(renderer->atlas);
+}
+
 /* ============================================================================
  * Public API Implementation
  * ============================================================================ */
@@ -213,6 +226,14 @@ ocfx_renderer_t* ocfx_renderer_create(ocfx_window_t *window) {
     glGenVertexArrays(1, &renderer->vao);
     glGenBuffers(1, &renderer->vbo);
 
+    /* Create glyph atlas */
+    renderer->atlas = ocfx_atlas_create(renderer);
+    if (!renderer->atlas) {
+        fprintf(stderr, "OCFX: Failed to create glyph atlas\n");
+        ocfx_renderer_destroy(renderer);
+        return NULL;
+    }
+
     /* Set up OpenGL state */
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -224,6 +245,7 @@ ocfx_renderer_t* ocfx_renderer_create(ocfx_window_t *window) {
 void ocfx_renderer_destroy(ocfx_renderer_t *renderer) {
     if (!renderer) return;
 
+    ocfx_atlas_destroy(renderer->atlas);
     if (renderer->vbo) glDeleteBuffers(1, &renderer->vbo);
     if (renderer->vao) glDeleteVertexArrays(1, &renderer->vao);
     if (renderer->basic_shader) glDeleteProgram(renderer->basic_shader);
@@ -247,23 +269,38 @@ void ocfx_renderer_destroy(ocfx_renderer_t *renderer) {
 void ocfx_render_begin(ocfx_renderer_t *renderer, ocfx_color_t clear_color) {
     if (!renderer) return;
 
+    renderer->frame++;
+    flush_text(renderer);
+
     glClearColor(clear_color.r, clear_color.g, clear_color.b, clear_color.a);
     glClear(GL_COLOR_BUFFER_BIT);
 }
 
 void ocfx_render_end(ocfx_renderer_t *renderer) {
     if (!renderer) return;
+    flush_text(renderer);
     glFlush();
 }
 
 void ocfx_render_present(ocfx_renderer_t *renderer) {
     if (!renderer) return;
+    flush_text(renderer);
     eglSwapBuffers(renderer->egl_display, renderer->egl_surface);
 }
 
+uint64_t ocfx_render_get_frame(ocfx_renderer_t *renderer) {
+    return renderer ? renderer->frame : 0;
+}
+
+/* Internal: glyph atlas accessor for text.c */
+ocfx_atlas_t* ocfx_renderer_get_atlas(ocfx_renderer_t *renderer) {
+    return renderer ? renderer->atlas : NULL;
+}
+
 /* Viewport */
 void ocfx_render_set_viewport(ocfx_renderer_t *renderer, int32_t width, int32_t height) {
     if (!renderer) return;
+    flush_text(renderer);
     renderer->viewport_width = width;
     renderer->viewport_height = height;
     glViewport(0, 0, width, height);
@@ -291,6 +328,7 @@ void ocfx_draw_rect_filled(ocfx_renderer_t *renderer, ocfx_rect_t rect, ocfx_col
         rect.x,             rect.y + rect.height, color.r, color.g, color.b, color.a,
     };
 
+    flush_text(renderer);
     glUseProgram(renderer->basic_shader);
 
     /* Set resolution uniform */
@@ -352,6 +390,7 @@ void ocfx_draw_line(ocfx_renderer_t *renderer, ocfx_point_t start, ocfx_point_t
         end.x + nx,   end.y + ny,   color.r, color.g, color.b, color.a,
     };
 
+    flush_text(renderer);
     glUseProgram(renderer->basic_shader);
     GLint u_resolution = glGetUniformLocation(renderer->basic_shader, "u_resolution");
     glUniform2f(u_resolution, (float)renderer->viewport_width, (float)renderer->viewport_height);
@@ -399,6 +438,7 @@ void ocfx_draw_circle_filled(ocfx_renderer_t *renderer, ocfx_point_t center,
         vertices[idx + 5] = color.a;
     }
 
+    flush_text(renderer);
     glUseProgram(renderer->basic_shader);
     GLint u_resolution = glGetUniformLocation(renderer->basic_shader, "u_resolution");
     glUniform2f(u_resolution, (float)renderer->viewport_width, (float)renderer->viewport_height);
@@ -439,6 +479,7 @@ void ocfx_draw_circle_outline(ocfx_renderer_t *renderer, ocfx_point_t center,
         vertices[idx + 5] = color.a;
     }
 
+    flush_text(renderer);
     glUseProgram(renderer->basic_shader);
     GLint u_resolution = glGetUniformLocation(renderer->basic_shader, "u_resolution");
     glUniform2f(u_resolution, (float)renderer->viewport_width, (float)renderer->viewport_height);
@@ -467,6 +508,7 @@ void ocfx_draw_triangle_filled(ocfx_renderer_t *renderer, ocfx_point_t p1,
         p3.x, p3.y, color.r, color.g, color.b, color.a,
     };
 
+    flush_text(renderer);
     glUseProgram(renderer->basic_shader);
     GLint u_resolution = glGetUniformLocation(renderer->basic_shader, "u_resolution");
     glUniform2f(u_resolution, (float)renderer->viewport_width, (float)renderer->viewport_height);
@@ -498,6 +540,7 @@ void ocfx_draw_quad_filled(ocfx_renderer_t *renderer, ocfx_point_t p1, ocfx_poin
         p4.x, p4.y, color.r, color.g, color.b, color.a,
     };
 
+    flush_text(renderer);
     glUseProgram(renderer->basic_shader);
     GLint u_resolution = glGetUniformLocation(renderer->basic_shader, "u_resolution");
     glUniform2f(u_resolution, (float)renderer->viewport_width, (float)renderer->viewport_height);
@@ -555,18 +598,20 @@ void ocfx_draw_texture(ocfx_renderer_t *renderer, ocfx_texture_t *texture,
 /* State management */
 void ocfx_render_push_clip(ocfx_renderer_t *renderer, ocfx_rect_t clip) {
     if (!renderer) return;
+    flush_text(renderer);
     glEnable(GL_SCISSOR_TEST);
     glScissor((GLint)clip.x, (GLint)(renderer->viewport_height - clip.y - clip.height),
               (GLsizei)clip.width, (GLsizei)clip.height);
 }
 
 void ocfx_render_pop_clip(ocfx_renderer_t *renderer) {
-    (void)renderer;
+    if (!renderer) return;
+    flush_text(renderer);
     glDisable(GL_SCISSOR_TEST);
 }
 
 void ocfx_render_set_blend_mode(ocfx_renderer_t *renderer, bool enabled) {
-    (void)renderer;
+    if (renderer) flush_text(renderer);
     if (enabled) {
         glEnable(GL_BLEND);
         glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -582,6 +627,9 @@ GLuint ocfx_renderer_get_shader(ocfx_renderer_t *renderer, const char *name) {
     if (strcmp(name, "basic") == 0) {
         return renderer->basic_shader;
     }
+    if (strcmp(name, "text") == 0) {
+        return ocfx_atlas_get_shader(renderer->atlas);
+    }
 
     return 0;
 }
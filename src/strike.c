@@ -0,0 +1,336 @@
+/* OCFX - Strike Files Implementation
+ * Mapping, building and writing serialized glyph sets
+ */
+
+#define _POSIX_C_SOURCE 200809L  /* For O_CLOEXEC */
+
+#include "strike.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define STRIKE_PADDING 1          /* Gap between glyphs in the image */
+
+/* ============================================================================
+ * Mapping
+ * ============================================================================ */
+
+bool ocfx_strike_map(const char *path, ocfx_strike_file_t *file) {
+    memset(file, 0, sizeof(*file));
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(ocfx_strike_header_t)) {
+        close(fd);
+        return false;
+    }
+
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return false;
+
+    file->data = data;
+    file->size = (size_t)st.st_size;
+    file->header = data;
+
+    /* Validate every table against the file size before trusting it */
+    const ocfx_strike_header_t *h = file->header;
+    uint64_t glyph_end = (uint64_t)h->glyph_offset + (uint64_t)h->glyph_count * sizeof(ocfx_strike_glyph_t);
+    uint64_t cmap_end = (uint64_t)h->cmap_offset + (uint64_t)h->cmap_count * sizeof(ocfx_strike_cmap_t);
+    uint64_t image_end = (uint64_t)h->image_offset + (uint64_t)h->image_width * h->image_height;
+    if (memcmp(h->magic, OCFX_STRIKE_MAGIC, 8) != 0 ||
+        h->version != OCFX_STRIKE_VERSION ||
+        h->header_size != sizeof(ocfx_strike_header_t) ||
+        h->glyph_offset % 4 || h->cmap_offset % 4 ||
+        glyph_end > file->size || cmap_end > file->size || image_end > file->size) {
+        ocfx_strike_unmap(file);
+        return false;
+    }
+
+    file->glyphs = (const ocfx_strike_glyph_t *)(file->data + h->glyph_offset);
+    file->cmap = (const ocfx_strike_cmap_t *)(file->data + h->cmap_offset);
+    file->image = file->data + h->image_offset;
+
+    for (uint32_t i = 0; i < h->glyph_count; i++) {
+        const ocfx_strike_glyph_t *g = &file->glyphs[i];
+        if ((uint32_t)g->x + g->width > h->image_width ||
+            (uint32_t)g->y + g->height > h->image_height) {
+            ocfx_strike_unmap(file);
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < h->cmap_count; i++) {
+        if (file->cmap[i].glyph >= h->glyph_count) {
+            ocfx_strike_unmap(file);
+            return false;
+        }
+    }
+    return true;
+}
+
+void ocfx_strike_unmap(ocfx_strike_file_t *file) {
+    if (file->data) munmap((void*)file->data, file->size);
+    memset(file, 0, sizeof(*file));
+}
+
+/* ============================================================================
+ * Building
+ * ============================================================================ */
+
+void ocfx_strike_builder_init(ocfx_strike_builder_t *builder, int width, int max_height) {
+    memset(builder, 0, sizeof(*builder));
+    builder->image_width = width;
+    builder->max_height = max_height;
+}
+
+/* Make sure rows [0, rows) of the image exist */
+static bool reserve_rows(ocfx_strike_builder_t *builder, int rows) {
+    if (rows <= builder->image_height) return true;
+    if (rows > builder->max_height) return false;
+
+    int new_rows = builder->image_height ? builder->image_height * 2 : 64;
+    if (new_rows < rows) new_rows = rows;
+    if (new_rows > builder->max_height) new_rows = builder->max_height;
+
+    uint8_t *image = realloc(builder->image, (size_t)new_rows * builder->image_width);
+    if (!image) return false;
+    memset(image + (size_t)builder->image_height * builder->image_width, 0,
+           (size_t)(new_rows - builder->image_height) * builder->image_width);
+    builder->image = image;
+    builder->image_height = new_rows;
+    return true;
+}
+
+static inline size_t lookup_slot(uint32_t glyph_index, size_t capacity) {
+    return (size_t)(glyph_index * 0x9E3779B1u) & (capacity - 1);
+}
+
+static void lookup_insert(ocfx_strike_builder_t *builder, uint32_t glyph_index, uint32_t record) {
+    size_t mask = builder->lookup_capacity - 1;
+    size_t slot = lookup_slot(glyph_index, builder->lookup_capacity);
+    while (builder->lookup[slot]) slot = (slot + 1) & mask;
+    builder->lookup[slot] = record + 1;
+}
+
+/* Keep the lookup at most half full for one more record */
+static bool reserve_lookup(ocfx_strike_builder_t *builder) {
+    if ((builder->glyph_count + 1) * 2 <= builder->lookup_capacity) return true;
+
+    size_t new_cap = builder->lookup_capacity ? builder->lookup_capacity * 2 : 256;
+    uint32_t *lookup = calloc(new_cap, sizeof(uint32_t));
+    if (!lookup) return false;
+    free(builder->lookup);
+    builder->lookup = lookup;
+    builder->lookup_capacity = new_cap;
+    for (size_t i = 0; i < builder->glyph_count; i++) {
+        lookup_insert(builder, builder->glyphs[i].glyph_index, (uint32_t)i);
+    }
+    return true;
+}
+
+bool ocfx_strike_builder_find(const ocfx_strike_builder_t *builder, uint32_t glyph_index,
+                              uint32_t *record) {
+    if (!builder->lookup) return false;
+    size_t mask = builder->lookup_capacity - 1;
+    for (size_t slot = lookup_slot(glyph_index, builder->lookup_capacity);
+         builder->lookup[slot]; slot = (slot + 1) & mask) {
+        uint32_t r = builder->lookup[slot] - 1;
+        if (builder->glyphs[r].glyph_index == glyph_index) {
+            *record = r;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool push_glyph_record(ocfx_strike_builder_t *builder, const ocfx_strike_glyph_t *glyph) {
+    if (!reserve_lookup(builder)) return false;
+    if (builder->glyph_count >= builder->glyph_capacity) {
+        size_t new_cap = builder->glyph_capacity ? builder->glyph_capacity * 2 : 128;
+        ocfx_strike_glyph_t *glyphs = realloc(builder->glyphs, new_cap * sizeof(ocfx_strike_glyph_t));
+        if (!glyphs) return false;
+        builder->glyphs = glyphs;
+        builder->glyph_capacity = new_cap;
+    }
+    lookup_insert(builder, glyph->glyph_index, (uint32_t)builder->glyph_count);
+    builder->glyphs[builder->glyph_count++] = *glyph;
+    return true;
+}
+
+bool ocfx_strike_builder_import(ocfx_strike_builder_t *builder, const ocfx_strike_file_t *file) {
+    const ocfx_strike_header_t *h = file->header;
+    if ((int)h->image_width != builder->image_width) return false;
+    if (!reserve_rows(builder, (int)h->image_height)) return false;
+
+    memcpy(builder->image, file->image, (size_t)h->image_width * h->image_height);
+    for (uint32_t i = 0; i < h->glyph_count; i++) {
+        if (!push_glyph_record(builder, &file->glyphs[i])) return false;
+    }
+    for (uint32_t i = 0; i < h->cmap_count; i++) {
+        if (!ocfx_strike_builder_map(builder, file->cmap[i].codepoint, file->cmap[i].glyph)) {
+            return false;
+        }
+    }
+
+    /* New glyphs go on fresh shelves below the imported ones */
+    builder->shelf_x = 0;
+    builder->shelf_y = (int)h->image_height;
+    builder->shelf_height = 0;
+    return true;
+}
+
+bool ocfx_strike_builder_add(ocfx_strike_builder_t *builder, uint32_t glyph_index,
+                             const uint8_t *bitmap, int width, int height, int pitch,
+                             float bearing_x, float bearing_y, float advance) {
+    int w = width + STRIKE_PADDING;
+    int h = height + STRIKE_PADDING;
+    if (w > builder->image_width) return false;
+
+    /* Shelf packing: glyphs of one strike have similar heights */
+    if (builder->shelf_x + w > builder->image_width) {
+        builder->shelf_x = 0;
+        builder->shelf_y += builder->shelf_height;
+        builder->shelf_height = 0;
+    }
+    if (!reserve_rows(builder, builder->shelf_y + h)) return false;
+
+    ocfx_strike_glyph_t glyph = {
+        .glyph_index = glyph_index,
+        .x = (uint16_t)builder->shelf_x,
+        .y = (uint16_t)builder->shelf_y,
+        .width = (uint16_t)width,
+        .height = (uint16_t)height,
+        .bearing_x = bearing_x,
+        .bearing_y = bearing_y,
+        .advance = advance,
+    };
+    if (!push_glyph_record(builder, &glyph)) return false;
+
+    for (int row = 0; row < height; row++) {
+        memcpy(builder->image + (size_t)(glyph.y + row) * builder->image_width + glyph.x,
+               bitmap + (ptrdiff_t)row * pitch, (size_t)width);
+    }
+
+    builder->shelf_x += w;
+    if (h > builder->shelf_height) builder->shelf_height = h;
+    return true;
+}
+
+bool ocfx_strike_builder_map(ocfx_strike_builder_t *builder, uint32_t codepoint, uint32_t glyph) {
+    if (builder->cmap_count >= builder->cmap_capacity) {
+        size_t new_cap = builder->cmap_capacity ? builder->cmap_capacity * 2 : 256;
+        ocfx_strike_cmap_t *cmap = realloc(builder->cmap, new_cap * sizeof(ocfx_strike_cmap_t));
+        if (!cmap) return false;
+        builder->cmap = cmap;
+        builder->cmap_capacity = new_cap;
+    }
+    builder->cmap[builder->cmap_count++] = (ocfx_strike_cmap_t){codepoint, glyph};
+    return true;
+}
+
+static int compare_cmap(const void *a, const void *b) {
+    uint32_t ca = ((const ocfx_strike_cmap_t *)a)->codepoint;
+    uint32_t cb = ((const ocfx_strike_cmap_t *)b)->codepoint;
+    return (ca > cb) - (ca < cb);
+}
+
+bool ocfx_strike_builder_write(ocfx_strike_builder_t *builder, const char *path,
+                               const ocfx_strike_header_t *info) {
+    /* Only the rows actually used are written */
+    int used_rows = builder->shelf_y + builder->shelf_height;
+    if (used_rows > builder->image_height) used_rows = builder->image_height;
+
+    if (builder->cmap_count) {
+        qsort(builder->cmap, builder->cmap_count, sizeof(ocfx_strike_cmap_t), compare_cmap);
+    }
+
+    ocfx_strike_header_t header = *info;
+    memcpy(header.magic, OCFX_STRIKE_MAGIC, 8);
+    header.version = OCFX_STRIKE_VERSION;
+    header.header_size = sizeof(ocfx_strike_header_t);
+    header.glyph_count = (uint32_t)builder->glyph_count;
+    header.cmap_count = (uint32_t)builder->cmap_count;
+    header.image_width = (uint32_t)builder->image_width;
+    header.image_height = (uint32_t)used_rows;
+    header.glyph_offset = sizeof(ocfx_strike_header_t);
+    header.cmap_offset = header.glyph_offset +
+                         (uint32_t)(builder->glyph_count * sizeof(ocfx_strike_glyph_t));
+    header.image_offset = header.cmap_offset +
+                          (uint32_t)(builder->cmap_count * sizeof(ocfx_strike_cmap_t));
+    header.reserved = 0;
+
+    /* Write to a temporary file and rename, so readers never see a torn file */
+    size_t tmp_len = strlen(path) + 16;
+    char *tmp_path = malloc(tmp_len);
+    if (!tmp_path) return false;
+    snprintf(tmp_path, tmp_len, "%s.%ld", path, (long)getpid());
+
+    FILE *fp = fopen(tmp_path, "wb");
+    if (!fp) {
+        free(tmp_path);
+        return false;
+    }
+
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+    if (ok && builder->glyph_count) {
+        ok = fwrite(builder->glyphs, sizeof(ocfx_strike_glyph_t), builder->glyph_count, fp) ==
+             builder->glyph_count;
+    }
+    if (ok && builder->cmap_count) {
+        ok = fwrite(builder->cmap, sizeof(ocfx_strike_cmap_t), builder->cmap_count, fp) ==
+             builder->cmap_count;
+    }
+    if (ok && used_rows) {
+        ok = fwrite(builder->image, (size_t)builder->image_width, (size_t)used_rows, fp) ==
+             (size_t)used_rows;
+    }
+    ok = (fclose(fp) == 0) && ok;
+
+    if (ok) ok = rename(tmp_path, path) == 0;
+    if (!ok) unlink(tmp_path);
+    free(tmp_path);
+    return ok;
+}
+
+void ocfx_strike_builder_free(ocfx_strike_builder_t *builder) {
+    free(builder->glyphs);
+    free(builder->lookup);
+    free(builder->cmap);
+    free(builder->image);
+    memset(builder, 0, sizeof(*builder));
+}
+
+/* ============================================================================
+ * Hashing
+ * ============================================================================ */
+
+uint64_t ocfx_strike_hash(const uint8_t *data, size_t size) {
+    /* Word-at-a-time multiply/rotate hash; fast enough to run over a
+     * multi-megabyte font file once per process */
+    const uint64_t prime = 0x9e3779b97f4a7c15ull;
+    uint64_t h = 0xcbf29ce484222325ull ^ size;
+    size_t i = 0;
+
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        h ^= word * prime;
+        h = (h << 31) | (h >> 33);
+        h *= 0xff51afd7ed558ccdull;
+    }
+    for (; i < size; i++) {
+        h ^= data[i];
+        h *= 0x100000001b3ull;
+    }
+
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
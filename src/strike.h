@@ -0,0 +1,100 @@
+/* OCFX - Strike Files (internal)
+ * Serialized glyph sets: one packed R8 image, per-glyph metrics and an
+ * optional codepoint map. Used for the on-disk glyph cache and for baked
+ * fonts (ocfx-fontc).
+ */
+
+#ifndef OCFX_STRIKE_H
+#define OCFX_STRIKE_H
+
+#include "ocfx/types.h"
+
+#define OCFX_STRIKE_MAGIC "OCFXSTK1"
+#define OCFX_STRIKE_VERSION 1
+
+/* File header. Integers are in host byte order and structs in host
+ * layout; a file written on a host of the other byte order fails the
+ * version check and is rejected, so baked fonts are built per byte order. */
+typedef struct {
+    char magic[8];                /* OCFX_STRIKE_MAGIC */
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t face_hash;           /* Hash of the font file contents */
+    int32_t size;                 /* Pixel size */
+    uint32_t mode;                /* ocfx_atlas_mode_t */
+    int32_t height, advance, ascent, descent;  /* Font metrics */
+    uint32_t glyph_count;
+    uint32_t cmap_count;          /* 0 when glyphs are looked up by cmap */
+    uint32_t image_width;
+    uint32_t image_height;
+    uint32_t glyph_offset;        /* File offsets of the three tables */
+    uint32_t cmap_offset;
+    uint32_t image_offset;
+    uint32_t reserved;
+} ocfx_strike_header_t;
+
+/* Glyph record: position in the strike image plus metrics */
+typedef struct {
+    uint32_t glyph_index;
+    uint16_t x, y;
+    uint16_t width, height;
+    float bearing_x, bearing_y;
+    float advance;
+} ocfx_strike_glyph_t;
+
+/* Codepoint map entry (sorted by codepoint) */
+typedef struct {
+    uint32_t codepoint;
+    uint32_t glyph;               /* Index into the glyph records */
+} ocfx_strike_cmap_t;
+
+/* Read-only mapped strike file; pointers reference the mapping */
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    const ocfx_strike_header_t *header;
+    const ocfx_strike_glyph_t *glyphs;
+    const ocfx_strike_cmap_t *cmap;
+    const uint8_t *image;
+} ocfx_strike_file_t;
+
+/* Strike being built: glyphs are shelf packed into an image of fixed
+ * width whose height grows up to max_height */
+typedef struct {
+    ocfx_strike_glyph_t *glyphs;
+    size_t glyph_count;
+    size_t glyph_capacity;
+    uint32_t *lookup;             /* Open-addressed glyph_index -> record + 1 */
+    size_t lookup_capacity;       /* Power of two, at most half full */
+    ocfx_strike_cmap_t *cmap;
+    size_t cmap_count;
+    size_t cmap_capacity;
+    uint8_t *image;
+    int image_width;
+    int image_height;             /* Allocated rows */
+    int max_height;
+    int shelf_x, shelf_y, shelf_height;
+} ocfx_strike_builder_t;
+
+/* Mapping */
+bool ocfx_strike_map(const char *path, ocfx_strike_file_t *file);
+void ocfx_strike_unmap(ocfx_strike_file_t *file);
+
+/* Building */
+void ocfx_strike_builder_init(ocfx_strike_builder_t *builder, int width, int max_height);
+bool ocfx_strike_builder_import(ocfx_strike_builder_t *builder, const ocfx_strike_file_t *file);
+bool ocfx_strike_builder_add(ocfx_strike_builder_t *builder, uint32_t glyph_index,
+                             const uint8_t *bitmap, int width, int height, int pitch,
+                             float bearing_x, float bearing_y, float advance);
+bool ocfx_strike_builder_map(ocfx_strike_builder_t *builder, uint32_t codepoint, uint32_t glyph);
+/* Record of a glyph index already added (or imported) */
+bool ocfx_strike_builder_find(const ocfx_strike_builder_t *builder, uint32_t glyph_index,
+                              uint32_t *record);
+bool ocfx_strike_builder_write(ocfx_strike_builder_t *builder, const char *path,
+                               const ocfx_strike_header_t *info);
+void ocfx_strike_builder_free(ocfx_strike_builder_t *builder);
+
+/* Content hash used to key strike files to a font file */
+uint64_t ocfx_strike_hash(const uint8_t *data, size_t size);
+
+#endif /* OCFX_STRIKE_H */
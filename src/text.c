@@ -1,34 +1,138 @@
 /* OCFX - Text Rendering Implementation
- * FreeType-based font rendering with GPU texture atlas
+ * FreeType-based font rendering with GPU texture atlas. Building with
+ * -DOCFX_NO_FREETYPE leaves only baked fonts (ocfx_font_load_baked).
  */
 
+#define _POSIX_C_SOURCE 200809L  /* For strdup and mkdir */
+
 #include "ocfx/text.h"
 #include "ocfx/render.h"
+#include "atlas.h"
+#include "font.h"
+#include "strike.h"
+#include "utf8.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
+#include <sys/stat.h>
+
+#ifndef OCFX_NO_FREETYPE
+#include "face.h"
+#include "fontindex.h"
+#include "raster.h"
+#include <time.h>
+#include <unistd.h>
 #include <ft2build.h>
 #include FT_FREETYPE_H
-#include <GLES3/gl3.h>
+#include FT_ADVANCES_H
+#include FT_OUTLINE_H
+
+/* FreeType renders signed distance fields natively since 2.11 */
+#if FREETYPE_MAJOR > 2 || (FREETYPE_MAJOR == 2 && FREETYPE_MINOR >= 11)
+#define OCFX_HAVE_FT_SDF 1
+#endif
+#endif
+
+#ifndef OCFX_GLYPH_CACHE_WIDTH
+#define OCFX_GLYPH_CACHE_WIDTH 1024   /* Width of cached strike images */
+#endif
+
+/* Horizontal glyph positions per pixel on subpixel fonts (at most 4: the
+ * phase takes the top two bits of the key's glyph word) */
+#ifndef OCFX_SUBPIXEL_PHASES
+#define OCFX_SUBPIXEL_PHASES 4
+#endif
+
+#define OCFX_GLYPH_INDEX_MASK ((1u << OCFX_GLYPH_PHASE_SHIFT) - 1)
+
+#define OCFX_ADVANCE_PAGE 256        /* Glyph indices per advance cache page */
+#define OCFX_DECODE_CHUNK 128        /* Codepoints decoded per bulk call */
+
+#ifndef OCFX_WRAP_CACHE_SIZE
+#define OCFX_WRAP_CACHE_SIZE 8       /* Layouts kept per font for draw_wrapped */
+#endif
+
+#ifndef OCFX_RUN_CACHE_WAYS
+#define OCFX_RUN_CACHE_WAYS 4        /* Entries per set of the run cache */
+#endif
 
-/* Glyph cache entry */
+/* On-disk glyph cache directory (NULL = disabled) */
+static char *glyph_cache_dir;
+
+/* How glyph misses are handled (see ocfx_text_set_glyph_loading) */
+static ocfx_glyph_loading_t glyph_loading = OCFX_GLYPH_SYNC;
+
+/* Strike ids of baked fonts live above those of the face registry */
+static uint32_t next_baked_id = 0x80000000u;
+
+/* Wrap cache entry (layout == NULL marks a free slot) */
+typedef struct {
+    uint64_t hash;
+    uint64_t last_used;           /* Renderer frame of the last draw */
+    char *text;                   /* Copy of the string, to rule out collisions */
+    ocfx_text_layout_t *layout;
+} wrap_cache_entry_t;
+
+/* Run cache entry (run == NULL marks a free way) */
+typedef struct {
+    uint64_t hash;
+    uint64_t last_used;           /* Renderer frame of the last draw */
+    size_t len;
+    char *text;                   /* Copy of the string, to rule out collisions */
+    ocfx_text_run_t *run;
+} run_cache_entry_t;
+
+/* Characters the numeric fast path draws, in slot order */
+#define OCFX_NUMERIC_CHARS "0123456789abcdef-."
+#define OCFX_NUMERIC_SLOTS 18
+
+/* Cached quad of one numeric character, relative to the pen at the top
+ * of the line (see ocfx_text_draw_int) */
 typedef struct {
-    uint32_t codepoint;
-    float atlas_x, atlas_y;      /* Position in atlas (normalized 0-1) */
-    float atlas_width, atlas_height;  /* Size in atlas (normalized) */
-    float width, height;          /* Size in pixels */
-    float bearing_x, bearing_y;   /* Bearing in pixels */
-    float advance;                /* Advance in pixels */
-} glyph_cache_entry_t;
+    ocfx_text_vertex_t quad[4];
+    uint32_t page;
+    uint32_t mode;
+    float advance;
+    bool visible;
+} numeric_glyph_t;
 
 /* Font structure (opaque to users) */
 struct ocfx_font_t {
     ocfx_renderer_t *renderer;
+    ocfx_atlas_t *atlas;          /* Renderer-wide glyph atlas */
 
-    /* FreeType */
-    FT_Library ft_library;
+#ifndef OCFX_NO_FREETYPE
+    /* FreeType: the face is shared with other sizes, the size is ours */
+    ocfx_face_t *face;
     FT_Face ft_face;
+    FT_Size ft_size;
+
+    /* Background rasterization: glyph indices with a job in flight (one
+     * bit each, reset when the worker pool restarts) and the blank glyph
+     * drawn in their place */
+    uint8_t *pending;
+    uint32_t pending_generation;
+    ocfx_glyph_t placeholder;
+
+    /* Advances for measurement, in pages of OCFX_ADVANCE_PAGE glyph
+     * indices (negative = unknown). Filled with FT_Get_Advance: no
+     * rasterization, no atlas space, no GL calls. */
+    float **advance_pages;
+#endif
     int size;
+    uint32_t strike;              /* Atlas strike (face + size + mode) */
+
+    /* Advances of ASCII codepoints for measurement, filled on first use
+     * and refilled if rasterization revises an advance */
+    float ascii_advance[128];
+    bool ascii_ready;
+    uint32_t mode;                /* ocfx_atlas_mode_t */
+    bool subpixel;                /* Fractional advances, glyphs cached per phase */
+
+    /* Fonts tried in order for codepoints this one lacks (not owned) */
+    ocfx_font_t **fallbacks;
+    size_t fallback_count;
 
     /* Font metrics */
     int height;
@@ -36,311 +140,739 @@ struct ocfx_font_t {
     int ascent;
     int descent;
 
-    /* GPU texture atlas */
-    GLuint texture;
-    int atlas_width;
-    int atlas_height;
-    int atlas_x;
-    int atlas_y;
-    int atlas_row_height;
-
-    /* Glyph cache */
-    glyph_cache_entry_t *glyph_cache;
-    size_t glyph_cache_size;
-    size_t glyph_cache_capacity;
-
-    /* Shader program for text */
-    GLuint shader_program;
-    GLuint vao;
-    GLuint vbo;
+    /* On-disk glyph cache: the file stays mapped until the first glyph
+     * it lacks is rasterized, then everything moves into the builder */
+    char *cache_path;
+    ocfx_strike_file_t cache_file;
+    ocfx_strike_builder_t cache_builder;
+    bool cache_dirty;
+
+    /* Baked font: mapped strike file with its own codepoint map */
+    ocfx_strike_file_t baked;
+
+    /* Automatic run cache (see ocfx_font_set_run_cache): run_cache_sets
+     * sets of OCFX_RUN_CACHE_WAYS entries, plus as many hashes per set of
+     * strings seen once */
+    run_cache_entry_t *run_cache;
+    uint64_t *run_seen;
+    size_t run_cache_sets;
+
+    /* Reused run for aligned draws (see ocfx_text_draw_aligned) */
+    ocfx_text_run_t *scratch;
+
+    /* Layouts of recently wrapped strings, re-wrapped incrementally */
+    wrap_cache_entry_t wrap_cache[OCFX_WRAP_CACHE_SIZE];
+
+    /* Numeric fast path: digit quads and tabular cell widths */
+    numeric_glyph_t *numeric;
+    uint32_t numeric_generation;
+    bool numeric_complete;
+    float digit_width;            /* Widest of 0-9 */
+    float hex_width;              /* Widest of 0-9, a-f */
 };
 
-/* Text vertex shader */
-static const char *text_vertex_shader =
-    "#version 300 es\n"
-    "precision highp float;\n"
-    "layout(location = 0) in vec2 a_position;\n"
-    "layout(location = 1) in vec2 a_texcoord;\n"
-    "layout(location = 2) in vec4 a_color;\n"
-    "out vec2 v_texcoord;\n"
-    "out vec4 v_color;\n"
-    "uniform vec2 u_resolution;\n"
-    "void main() {\n"
-    "    vec2 clip_pos = (a_position / u_resolution) * 2.0 - 1.0;\n"
-    "    clip_pos.y = -clip_pos.y;\n"
-    "    gl_Position = vec4(clip_pos, 0.0, 1.0);\n"
-    "    v_texcoord = a_texcoord;\n"
-    "    v_color = a_color;\n"
-    "}\n";
-
-/* Text fragment shader */
-static const char *text_fragment_shader =
-    "#version 300 es\n"
-    "precision highp float;\n"
-    "in vec2 v_texcoord;\n"
-    "in vec4 v_color;\n"
-    "out vec4 fragColor;\n"
-    "uniform sampler2D u_texture;\n"
-    "void main() {\n"
-    "    float alpha = texture(u_texture, v_texcoord).r;\n"
-    "    fragColor = vec4(v_color.rgb, v_color.a * alpha);\n"
-    "}\n";
-
-/* Compile shader (copied from render.c pattern) */
-static GLuint compile_text_shader(GLenum type, const char *source) {
-    GLuint shader = glCreateShader(type);
-    glShaderSource(shader, 1, &source, NULL);
-    glCompileShader(shader);
-
-    GLint success;
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        char info_log[512];
-        glGetShaderInfoLog(shader, sizeof(info_log), NULL, info_log);
-        fprintf(stderr, "OCFX: Text shader compilation failed: %s\n", info_log);
-        return 0;
+
+/* Map a codepoint to a glyph record of a baked font (record 0 = .notdef) */
+static uint32_t baked_glyph_index(const ocfx_strike_file_t *file, uint32_t codepoint) {
+    const ocfx_strike_cmap_t *cmap = file->cmap;
+    size_t lo = 0, hi = file->header->cmap_count;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (cmap[mid].codepoint < codepoint) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
     }
-    return shader;
+    return (lo < file->header->cmap_count && cmap[lo].codepoint == codepoint) ? cmap[lo].glyph : 0;
 }
 
-/* Create text shader program */
-static GLuint create_text_shader_program(void) {
-    GLuint vert = compile_text_shader(GL_VERTEX_SHADER, text_vertex_shader);
-    GLuint frag = compile_text_shader(GL_FRAGMENT_SHADER, text_fragment_shader);
+/* Upload a baked font's whole image and register all of its glyphs. Runs
+ * at load and again whenever the atlas has evicted the page holding it. */
+static bool upload_baked(ocfx_font_t *font) {
+    const ocfx_strike_file_t *file = &font->baked;
+    const ocfx_strike_header_t *h = file->header;
+
+    uint32_t page = 0;
+    int x = 0, y = 0;
+    if (!ocfx_atlas_upload(font->atlas, file->image, (int)h->image_width, (int)h->image_height,
+                           (int)h->image_width, &page, &x, &y)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < h->glyph_count; i++) {
+        const ocfx_strike_glyph_t *g = &file->glyphs[i];
+        if (!ocfx_atlas_add(font->atlas, OCFX_GLYPH_KEY(font->strike, i), page,
+                            x + g->x, y + g->y, g->width, g->height,
+                            g->bearing_x, g->bearing_y, g->advance)) {
+            return false;
+        }
+    }
+    return true;
+}
 
-    if (!vert || !frag) return 0;
+#ifndef OCFX_NO_FREETYPE
 
-    GLuint program = glCreateProgram();
-    glAttachShader(program, vert);
-    glAttachShader(program, frag);
-    glLinkProgram(program);
+/* Advance cache entry of a glyph index (NULL if out of range or memory) */
+static float* advance_slot(ocfx_font_t *font, uint32_t glyph_index) {
+    if (glyph_index >= (uint32_t)font->ft_face->num_glyphs) return NULL;
 
-    GLint success;
-    glGetProgramiv(program, GL_LINK_STATUS, &success);
-    if (!success) {
-        char info_log[512];
-        glGetProgramInfoLog(program, sizeof(info_log), NULL, info_log);
-        fprintf(stderr, "OCFX: Text shader linking failed: %s\n", info_log);
-        return 0;
+    size_t page = glyph_index / OCFX_ADVANCE_PAGE;
+    if (!font->advance_pages) {
+        size_t pages = ((size_t)font->ft_face->num_glyphs + OCFX_ADVANCE_PAGE - 1) /
+                       OCFX_ADVANCE_PAGE;
+        font->advance_pages = calloc(pages, sizeof(float*));
+        if (!font->advance_pages) return NULL;
     }
+    if (!font->advance_pages[page]) {
+        float *advances = malloc(OCFX_ADVANCE_PAGE * sizeof(float));
+        if (!advances) return NULL;
+        for (int i = 0; i < OCFX_ADVANCE_PAGE; i++) advances[i] = -1.0f;
+        font->advance_pages[page] = advances;
+    }
+    return &font->advance_pages[page][glyph_index % OCFX_ADVANCE_PAGE];
+}
 
-    glDeleteShader(vert);
-    glDeleteShader(frag);
+/* Remember an advance learned while rasterizing or loading the cache */
+static inline void store_advance(ocfx_font_t *font, uint32_t glyph_index, float advance) {
+    float *slot = advance_slot(font, glyph_index);
+    if (!slot) return;
+    if (*slot != advance) font->ascii_ready = false;
+    *slot = advance;
+}
 
-    return program;
+/* Advance of a glyph index without rendering it. Uses the load flags of
+ * cache_glyph, so the result matches the drawn (hinted) advance; subpixel
+ * fonts keep the unhinted fraction. */
+static float ft_glyph_advance(ocfx_font_t *font, uint32_t glyph_index) {
+    float *advance = advance_slot(font, glyph_index);
+    if (!advance) return 0.0f;
+    if (*advance < 0.0f) {
+        FT_Fixed value = 0;
+        FT_Activate_Size(font->ft_size);
+        if (font->subpixel) {
+            FT_Get_Advance(font->ft_face, glyph_index, FT_LOAD_NO_HINTING, &value);
+            *advance = (float)value / 65536.0f;
+        } else {
+            FT_Get_Advance(font->ft_face, glyph_index, FT_LOAD_DEFAULT, &value);
+            *advance = (float)(value >> 16);
+        }
+    }
+    return *advance;
 }
 
-/* Find glyph in cache */
-static glyph_cache_entry_t* find_glyph(ocfx_font_t *font, uint32_t codepoint) {
-    for (size_t i = 0; i < font->glyph_cache_size; i++) {
-        if (font->glyph_cache[i].codepoint == codepoint) {
-            return &font->glyph_cache[i];
+/* Record a freshly rasterized glyph for the on-disk cache (glyph_id is
+ * the key's glyph word, so phases of subpixel fonts are told apart) */
+static void record_glyph(ocfx_font_t *font, uint32_t glyph_id,
+                         const uint8_t *bitmap, int width, int height, int pitch,
+                         float bearing_x, float bearing_y, float advance) {
+    ocfx_strike_builder_t *builder = &font->cache_builder;
+
+    if (font->cache_file.data) {
+        if (!ocfx_strike_builder_import(builder, &font->cache_file)) {
+            /* Unusable layout (e.g. different GPU limits): start over */
+            int image_width = builder->image_width, max_height = builder->max_height;
+            ocfx_strike_builder_free(builder);
+            ocfx_strike_builder_init(builder, image_width, max_height);
         }
+        ocfx_strike_unmap(&font->cache_file);
+    }
+
+    /* Evicted glyphs come back through here; keep one copy */
+    uint32_t record;
+    if (ocfx_strike_builder_find(builder, glyph_id, &record)) return;
+
+    if (ocfx_strike_builder_add(builder, glyph_id, bitmap, width, height, pitch,
+                                bearing_x, bearing_y, advance)) {
+        font->cache_dirty = true;
     }
-    return NULL;
 }
 
-/* Add glyph to cache and atlas */
-static glyph_cache_entry_t* cache_glyph(ocfx_font_t *font, uint32_t codepoint) {
-    /* Load glyph */
-    if (FT_Load_Char(font->ft_face, codepoint, FT_LOAD_RENDER)) {
-        return NULL;
+static inline uint32_t glyph_phases(const ocfx_font_t *font) {
+    return font->subpixel ? OCFX_SUBPIXEL_PHASES : 1;
+}
+
+/* Subpixel phase of a glyph key (0 on other fonts) */
+static inline uint32_t key_phase(uint64_t key) {
+    return (uint32_t)key >> OCFX_GLYPH_PHASE_SHIFT;
+}
+
+/* Bit of a glyph id (key glyph word) in the pending set: one run of
+ * num_glyphs bits per phase */
+static bool pending_bit(ocfx_font_t *font, uint32_t glyph_id, size_t *bit) {
+    uint32_t glyph_index = glyph_id & OCFX_GLYPH_INDEX_MASK;
+    uint32_t phase = glyph_id >> OCFX_GLYPH_PHASE_SHIFT;
+    if (glyph_index >= (uint32_t)font->ft_face->num_glyphs || phase >= glyph_phases(font)) {
+        return false;
     }
+    *bit = (size_t)phase * (size_t)font->ft_face->num_glyphs + glyph_index;
+    return true;
+}
 
-    FT_GlyphSlot slot = font->ft_face->glyph;
+/* Pending bit of a glyph (the set is dropped when the pool restarts) */
+static bool pending_test_and_set(ocfx_font_t *font, uint32_t glyph_id) {
+    size_t bit;
+    if (!pending_bit(font, glyph_id, &bit)) return true;
+
+    if (!font->pending || font->pending_generation != ocfx_raster_generation()) {
+        size_t bits = (size_t)font->ft_face->num_glyphs * glyph_phases(font);
+        free(font->pending);
+        font->pending = calloc((bits + 7) / 8, 1);
+        font->pending_generation = ocfx_raster_generation();
+        if (!font->pending) return true;
+    }
 
-    /* Check if we need a new row in atlas */
-    if (font->atlas_x + slot->bitmap.width > (unsigned)font->atlas_width) {
-        font->atlas_x = 0;
-        font->atlas_y += font->atlas_row_height;
-        font->atlas_row_height = 0;
+    uint8_t mask = (uint8_t)(1u << (bit & 7));
+    bool was_set = font->pending[bit >> 3] & mask;
+    font->pending[bit >> 3] |= mask;
+    return was_set;
+}
+
+static void pending_clear(ocfx_font_t *font, uint32_t glyph_id) {
+    size_t bit;
+    if (font->pending && font->pending_generation == ocfx_raster_generation() &&
+        pending_bit(font, glyph_id, &bit)) {
+        font->pending[bit >> 3] &= (uint8_t)~(1u << (bit & 7));
     }
+}
 
-    /* Check if atlas is full */
-    if (font->atlas_y + slot->bitmap.rows > (unsigned)font->atlas_height) {
-        fprintf(stderr, "OCFX: Font atlas full!\n");
-        return NULL;
+/* Queue a glyph for the worker pool unless it is already on its way.
+ * Draws ask with urgent set, which also moves a glyph still waiting in
+ * the background (prewarm) queue ahead of it. */
+static void request_glyph(ocfx_font_t *font, uint32_t glyph_index, uint64_t key, bool urgent) {
+    if (pending_test_and_set(font, (uint32_t)key)) {
+        if (urgent) ocfx_raster_promote(font, key);
+        return;
+    }
+
+    ocfx_raster_job_t job = {
+        .owner = font,
+        .face_id = font->face->id,
+        .data = font->face->data,
+        .data_size = font->face->size,
+        .size = font->size,
+        .mode = font->mode,
+        .glyph_index = glyph_index,
+        .key = key,
+        .subpixel = font->subpixel,
+        .x_offset = (int)(key_phase(key) * 64 / OCFX_SUBPIXEL_PHASES),
+        .urgent = urgent,
+    };
+    if (!ocfx_raster_submit(&job)) pending_clear(font, (uint32_t)key);
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/* Upload finished background glyphs (render thread). With a budget, stop
+ * once atlas has used up this frame's share; the rest waits in the pool. */
+static void collect_glyphs(ocfx_atlas_t *budget) {
+    ocfx_raster_job_t jobs[16];
+    size_t n;
+    while ((!budget || ocfx_atlas_budget_available(budget)) &&
+           (n = ocfx_raster_collect(jobs, 16)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            ocfx_raster_job_t *job = &jobs[i];
+            ocfx_font_t *font = job->owner;
+            pending_clear(font, (uint32_t)job->key);
+            if (job->ok) store_advance(font, job->glyph_index, job->advance);
+
+            if (job->ok && !ocfx_atlas_find(font->atlas, job->key)) {
+                ocfx_atlas_budget_charge(font->atlas, (size_t)job->width * job->height, 0);
+                if (font->cache_path) {
+                    record_glyph(font, (uint32_t)job->key, job->bitmap, job->width, job->height,
+                                 job->width, job->bearing_x, job->bearing_y, job->advance);
+                }
+                ocfx_atlas_insert(font->atlas, job->key, job->bitmap,
+                                  job->width, job->height, job->width,
+                                  job->bearing_x, job->bearing_y, job->advance);
+            }
+            free(job->bitmap);
+        }
     }
+}
+
+/* Blank stand-in for a glyph still being rasterized: right advance, no quad */
+static ocfx_glyph_t* placeholder_glyph(ocfx_font_t *font, uint32_t glyph_index) {
+    memset(&font->placeholder, 0, sizeof(font->placeholder));
+    font->placeholder.advance = ft_glyph_advance(font, glyph_index);
+    return &font->placeholder;
+}
+
+#endif /* OCFX_NO_FREETYPE */
+
+/* Map a codepoint to a glyph index of the font's face (or record of a
+ * baked font) */
+static inline uint32_t font_glyph_index(ocfx_font_t *font, uint32_t codepoint) {
+#ifdef OCFX_NO_FREETYPE
+    return baked_glyph_index(&font->baked, codepoint);
+#else
+    if (font->baked.data) return baked_glyph_index(&font->baked, codepoint);
+    if (codepoint < 256) return font->face->latin1_index[codepoint];
+    return FT_Get_Char_Index(font->ft_face, codepoint);
+#endif
+}
+
+/* Does the font have a glyph for codepoint? Faces answer from their
+ * coverage bitmap, baked fonts from their codepoint map. */
+static inline bool font_covers(ocfx_font_t *font, uint32_t codepoint) {
+#ifndef OCFX_NO_FREETYPE
+    if (!font->baked.data) return ocfx_face_covers(font->face, codepoint);
+#endif
+    return baked_glyph_index(&font->baked, codepoint) != 0;
+}
 
-    /* Upload glyph to atlas */
-    glBindTexture(GL_TEXTURE_2D, font->texture);
-    glTexSubImage2D(GL_TEXTURE_2D, 0,
-                    font->atlas_x, font->atlas_y,
-                    slot->bitmap.width, slot->bitmap.rows,
-                    GL_RED, GL_UNSIGNED_BYTE,
-                    slot->bitmap.buffer);
+/* Font of the chain that draws codepoint, and its glyph index there. The
+ * primary font answers first; codepoints no font has stay with the
+ * primary (and its .notdef glyph). */
+static inline ocfx_font_t* resolve_codepoint(ocfx_font_t *font, uint32_t codepoint,
+                                             uint32_t *glyph_index) {
+    *glyph_index = font_glyph_index(font, codepoint);
+    if (*glyph_index || !font->fallback_count) return font;
+
+    for (size_t i = 0; i < font->fallback_count; i++) {
+        ocfx_font_t *fallback = font->fallbacks[i];
+        if (font_covers(fallback, codepoint)) {
+            *glyph_index = font_glyph_index(fallback, codepoint);
+            return fallback;
+        }
+    }
+    return font;
+}
 
-    /* Grow cache if needed */
-    if (font->glyph_cache_size >= font->glyph_cache_capacity) {
-        size_t new_cap = font->glyph_cache_capacity * 2;
-        if (new_cap == 0) new_cap = 128;
+/* Advance of a codepoint for measurement (never touches the atlas) */
+static inline float codepoint_advance(ocfx_font_t *font, uint32_t codepoint) {
+    uint32_t glyph_index;
+    font = resolve_codepoint(font, codepoint, &glyph_index);
+#ifdef OCFX_NO_FREETYPE
+    return font->baked.glyphs[glyph_index].advance;
+#else
+    if (font->baked.data) return font->baked.glyphs[glyph_index].advance;
+    return ft_glyph_advance(font, glyph_index);
+#endif
+}
 
-        glyph_cache_entry_t *new_cache = realloc(font->glyph_cache,
-                                                   new_cap * sizeof(glyph_cache_entry_t));
-        if (!new_cache) return NULL;
+static const float* ascii_advances(ocfx_font_t *font) {
+    if (!font->ascii_ready) {
+        for (uint32_t c = 0; c < 128; c++) font->ascii_advance[c] = codepoint_advance(font, c);
+        font->ascii_ready = true;
+    }
+    return font->ascii_advance;
+}
 
-        font->glyph_cache = new_cache;
-        font->glyph_cache_capacity = new_cap;
+/* Rasterize a glyph (coverage bitmap or distance field) and add it to the atlas */
+static ocfx_glyph_t* cache_glyph(ocfx_font_t *font, uint32_t glyph_index, uint64_t key) {
+    /* Baked glyphs are never rasterized: a miss means the page was evicted */
+    if (font->baked.data) {
+        if (!upload_baked(font)) return NULL;
+        return ocfx_atlas_find(font->atlas, key);
     }
 
-    /* Add to cache */
-    glyph_cache_entry_t *entry = &font->glyph_cache[font->glyph_cache_size++];
-    entry->codepoint = codepoint;
-    entry->atlas_x = (float)font->atlas_x / font->atlas_width;
-    entry->atlas_y = (float)font->atlas_y / font->atlas_height;
-    entry->atlas_width = (float)slot->bitmap.width / font->atlas_width;
-    entry->atlas_height = (float)slot->bitmap.rows / font->atlas_height;
-    entry->width = (float)slot->bitmap.width;
-    entry->height = (float)slot->bitmap.rows;
-    entry->bearing_x = (float)slot->bitmap_left;
-    entry->bearing_y = (float)slot->bitmap_top;
-    entry->advance = (float)(slot->advance.x >> 6);
+#ifdef OCFX_NO_FREETYPE
+    (void)glyph_index;
+    return NULL;
+#else
+    /* The face is shared: select this font's size first */
+    FT_Activate_Size(font->ft_size);
+
+    if (font->mode == OCFX_ATLAS_MODE_SDF) {
+#ifdef OCFX_HAVE_FT_SDF
+        if (FT_Load_Glyph(font->ft_face, glyph_index, FT_LOAD_DEFAULT) ||
+            FT_Render_Glyph(font->ft_face->glyph, FT_RENDER_MODE_SDF)) {
+            return NULL;
+        }
+#else
+        return NULL;
+#endif
+    } else if (font->subpixel) {
+        /* Light hinting keeps the outline's horizontal shape, so shifting
+         * it by the phase is the same glyph a fraction of a pixel over */
+        FT_GlyphSlot slot = font->ft_face->glyph;
+        if (FT_Load_Glyph(font->ft_face, glyph_index, FT_LOAD_TARGET_LIGHT)) return NULL;
+        if (slot->format == FT_GLYPH_FORMAT_OUTLINE) {
+            FT_Outline_Translate(&slot->outline,
+                                 (FT_Pos)(key_phase(key) * 64 / OCFX_SUBPIXEL_PHASES), 0);
+        }
+        if (FT_Render_Glyph(slot, FT_RENDER_MODE_NORMAL)) return NULL;
+    } else if (FT_Load_Glyph(font->ft_face, glyph_index, FT_LOAD_RENDER)) {
+        return NULL;
+    }
 
-    /* Update atlas position */
-    font->atlas_x += slot->bitmap.width;
-    if (slot->bitmap.rows > font->atlas_row_height) {
-        font->atlas_row_height = slot->bitmap.rows;
+    FT_GlyphSlot slot = font->ft_face->glyph;
+    float advance = font->subpixel ? (float)slot->linearHoriAdvance / 65536.0f :
+                                     (float)(slot->advance.x >> 6);
+    store_advance(font, glyph_index, advance);
+    if (font->cache_path) {
+        record_glyph(font, (uint32_t)key, slot->bitmap.buffer,
+                     (int)slot->bitmap.width, (int)slot->bitmap.rows, slot->bitmap.pitch,
+                     (float)slot->bitmap_left, (float)slot->bitmap_top, advance);
     }
 
-    return entry;
+    return ocfx_atlas_insert(font->atlas, key,
+                             slot->bitmap.buffer,
+                             (int)slot->bitmap.width, (int)slot->bitmap.rows,
+                             slot->bitmap.pitch,
+                             (float)slot->bitmap_left, (float)slot->bitmap_top,
+                             advance);
+#endif
+}
+
+/* Key of a glyph at a subpixel phase (ignored by other fonts) */
+static inline uint64_t phase_key(ocfx_font_t *font, uint32_t glyph_index, uint32_t phase) {
+    if (font->subpixel) glyph_index |= phase << OCFX_GLYPH_PHASE_SHIFT;
+    return OCFX_GLYPH_KEY(font->strike, glyph_index);
 }
 
-/* Get or cache glyph */
-static glyph_cache_entry_t* get_glyph(ocfx_font_t *font, uint32_t codepoint) {
-    glyph_cache_entry_t *entry = find_glyph(font, codepoint);
-    if (!entry) {
-        entry = cache_glyph(font, codepoint);
+/* Get or cache glyph at a subpixel phase (the atlas stamps it with the
+ * current frame) */
+static ocfx_glyph_t* get_glyph_phase(ocfx_font_t *font, uint32_t codepoint, uint32_t phase) {
+    uint32_t glyph_index;
+    font = resolve_codepoint(font, codepoint, &glyph_index);
+    uint64_t key = phase_key(font, glyph_index, phase);
+
+    ocfx_glyph_t *glyph = ocfx_atlas_find(font->atlas, key);
+    if (glyph) return glyph;
+
+#ifndef OCFX_NO_FREETYPE
+    if (glyph_loading != OCFX_GLYPH_SYNC && !font->baked.data && ocfx_raster_running()) {
+        request_glyph(font, glyph_index, key, true);
+        if (glyph_loading == OCFX_GLYPH_PLACEHOLDER) {
+            return placeholder_glyph(font, glyph_index);
+        }
+        ocfx_raster_wait_urgent(font);
+        collect_glyphs(NULL);
+        glyph = ocfx_atlas_find(font->atlas, key);
+
+        /* Still in a background batch a worker took before the request:
+         * render it here rather than wait for the rest of that batch */
+        return glyph ? glyph : cache_glyph(font, glyph_index, key);
+    }
+
+    /* Over this frame's budget: draw a blank advance, try next frame */
+    if (!font->baked.data) {
+        if (!ocfx_atlas_budget_available(font->atlas)) {
+            return placeholder_glyph(font, glyph_index);
+        }
+
+        uint64_t start = now_ns();
+        glyph = cache_glyph(font, glyph_index, key);
+        if (glyph) {
+            ocfx_atlas_budget_charge(font->atlas, (size_t)(glyph->width * glyph->height),
+                                     now_ns() - start);
+        }
+        return glyph;
     }
-    return entry;
+#endif
+
+    return cache_glyph(font, glyph_index, key);
 }
 
-/* UTF-8 decoding helper
- * Decodes the next UTF-8 character from the string and advances the pointer.
- * Returns the Unicode codepoint, or 0 on error.
- * Updates *str to point to the next character.
- */
-static uint32_t utf8_decode(const char **str) {
-    const unsigned char *s = (const unsigned char *)*str;
-    uint32_t codepoint = 0;
-    int bytes = 0;
-
-    if (!s || !*s) return 0;
-
-    /* 1-byte sequence: 0xxxxxxx */
-    if ((*s & 0x80) == 0) {
-        codepoint = *s;
-        bytes = 1;
-    }
-    /* 2-byte sequence: 110xxxxx 10xxxxxx */
-    else if ((*s & 0xE0) == 0xC0) {
-        codepoint = (*s & 0x1F) << 6;
-        if ((s[1] & 0xC0) != 0x80) return 0;  /* Invalid continuation */
-        codepoint |= (s[1] & 0x3F);
-        bytes = 2;
-    }
-    /* 3-byte sequence: 1110xxxx 10xxxxxx 10xxxxxx */
-    else if ((*s & 0xF0) == 0xE0) {
-        codepoint = (*s & 0x0F) << 12;
-        if ((s[1] & 0xC0) != 0x80) return 0;
-        codepoint |= (s[1] & 0x3F) << 6;
-        if ((s[2] & 0xC0) != 0x80) return 0;
-        codepoint |= (s[2] & 0x3F);
-        bytes = 3;
-    }
-    /* 4-byte sequence: 11110xxx 10xxxxxx 10xxxxxx 10xxxxxx */
-    else if ((*s & 0xF8) == 0xF0) {
-        codepoint = (*s & 0x07) << 18;
-        if ((s[1] & 0xC0) != 0x80) return 0;
-        codepoint |= (s[1] & 0x3F) << 12;
-        if ((s[2] & 0xC0) != 0x80) return 0;
-        codepoint |= (s[2] & 0x3F) << 6;
-        if ((s[3] & 0xC0) != 0x80) return 0;
-        codepoint |= (s[3] & 0x3F);
-        bytes = 4;
-    }
-    /* Invalid UTF-8 sequence */
-    else {
-        bytes = 1;  /* Skip this byte */
-        codepoint = '?';  /* Replacement character */
-    }
-
-    *str += bytes;
-    return codepoint;
+static inline ocfx_glyph_t* get_glyph(ocfx_font_t *font, uint32_t codepoint) {
+    return get_glyph_phase(font, codepoint, 0);
+}
+
+/* Glyph for a pen at x. Subpixel fonts pick the phase nearest the pen's
+ * fraction and set *quad_x to the whole pixel the quad is drawn from;
+ * other fonts draw from x itself. */
+static ocfx_glyph_t* glyph_at(ocfx_font_t *font, uint32_t codepoint, float x, float *quad_x) {
+    if (!font->subpixel) {
+        *quad_x = x;
+        return get_glyph(font, codepoint);
+    }
+
+    float whole = floorf(x);
+    uint32_t phase = (uint32_t)((x - whole) * OCFX_SUBPIXEL_PHASES + 0.5f);
+    if (phase >= OCFX_SUBPIXEL_PHASES) {
+        whole += 1.0f;
+        phase = 0;
+    }
+    *quad_x = whole;
+    return get_glyph_phase(font, codepoint, phase);
 }
 
 /* ============================================================================
- * Public API Implementation
+ * Font loading
  * ============================================================================ */
 
-ocfx_font_t* ocfx_font_load(ocfx_renderer_t *renderer, const char *font_path, int size) {
+#ifndef OCFX_NO_FREETYPE
+/* Upload a cached strike (if any) in one block and keep it mapped */
+static void load_glyph_cache(ocfx_font_t *font) {
+    const char *mode_name = font->mode == OCFX_ATLAS_MODE_SDF ? "sdf" :
+                            font->subpixel ? "subpixel" : "bitmap";
+    size_t len = strlen(glyph_cache_dir) + 48;
+    font->cache_path = malloc(len);
+    if (!font->cache_path) return;
+    snprintf(font->cache_path, len, "%s/%016llx-%d-%s.ocfxc", glyph_cache_dir,
+             (unsigned long long)ocfx_face_hash(font->face), font->size, mode_name);
+
+    int max_size = ocfx_atlas_get_max_size(font->atlas);
+    int width = max_size < OCFX_GLYPH_CACHE_WIDTH ? max_size : OCFX_GLYPH_CACHE_WIDTH;
+    ocfx_strike_builder_init(&font->cache_builder, width, max_size);
+
+    ocfx_strike_file_t *file = &font->cache_file;
+    if (!ocfx_strike_map(font->cache_path, file)) return;
+
+    const ocfx_strike_header_t *h = file->header;
+    if (h->face_hash != ocfx_face_hash(font->face) || h->size != font->size ||
+        h->mode != font->mode || (int)h->image_width != width || (int)h->image_height > max_size) {
+        ocfx_strike_unmap(file);
+        return;
+    }
+    if (h->glyph_count == 0) return;
+
+    /* Seed the advance cache so measuring needs no glyph loads either */
+    for (uint32_t i = 0; i < h->glyph_count; i++) {
+        store_advance(font, file->glyphs[i].glyph_index & OCFX_GLYPH_INDEX_MASK,
+                      file->glyphs[i].advance);
+    }
+
+    /* Another font of the same strike may have uploaded it already */
+    if (ocfx_atlas_has_strike_block(font->atlas, font->strike)) return;
+
+    uint32_t page = 0;
+    int x = 0, y = 0;
+    if (!ocfx_atlas_upload(font->atlas, file->image, (int)h->image_width, (int)h->image_height,
+                           (int)h->image_width, &page, &x, &y)) {
+        return;
+    }
+    ocfx_atlas_set_strike_block(font->atlas, font->strike, page);
+    for (uint32_t i = 0; i < h->glyph_count; i++) {
+        const ocfx_strike_glyph_t *g = &file->glyphs[i];
+        uint64_t key = OCFX_GLYPH_KEY(font->strike, g->glyph_index);
+        if (ocfx_atlas_find(font->atlas, key)) continue;  /* Rasterized before the upload */
+        if (!ocfx_atlas_add(font->atlas, key, page, x + g->x, y + g->y, g->width, g->height,
+                            g->bearing_x, g->bearing_y, g->advance)) {
+            break;
+        }
+    }
+}
+
+/* Load a face at a pixel size, rendering glyphs in the given atlas mode
+ * (subpixel: per-phase coverage glyphs with fractional advances) */
+static ocfx_font_t* load_font(ocfx_renderer_t *renderer, const char *font_path, int size,
+                              uint32_t mode, bool subpixel) {
     if (!renderer || !font_path || size <= 0) return NULL;
 
     ocfx_font_t *font = calloc(1, sizeof(ocfx_font_t));
     if (!font) return NULL;
 
     font->renderer = renderer;
+    font->atlas = ocfx_renderer_get_atlas(renderer);
     font->size = size;
+    font->mode = mode;
+    font->subpixel = subpixel;
 
-    /* Initialize FreeType */
-    if (FT_Init_FreeType(&font->ft_library)) {
-        fprintf(stderr, "OCFX: Failed to initialize FreeType\n");
+    if (!font->atlas) {
         free(font);
         return NULL;
     }
 
-    /* Load font */
-    if (FT_New_Face(font->ft_library, font_path, 0, &font->ft_face)) {
+    /* Map the file once and share the face across sizes */
+    font->face = ocfx_face_acquire(font_path);
+    if (!font->face) {
         fprintf(stderr, "OCFX: Failed to load font: %s\n", font_path);
-        FT_Done_FreeType(font->ft_library);
         free(font);
         return NULL;
     }
+    font->ft_face = font->face->ft_face;
 
-    /* Set size */
+    /* Own size object on the shared face */
+    if (FT_New_Size(font->ft_face, &font->ft_size)) {
+        ocfx_font_destroy(font);
+        return NULL;
+    }
+    FT_Activate_Size(font->ft_size);
     FT_Set_Pixel_Sizes(font->ft_face, 0, size);
 
     /* Get metrics */
-    font->height = font->ft_face->size->metrics.height >> 6;
-    font->advance = font->ft_face->size->metrics.max_advance >> 6;
-    font->ascent = font->ft_face->size->metrics.ascender >> 6;
-    font->descent = font->ft_face->size->metrics.descender >> 6;
-
-    /* Create texture atlas */
-    font->atlas_width = 2048;
-    font->atlas_height = 2048;
-    font->atlas_x = 0;
-    font->atlas_y = 0;
-    font->atlas_row_height = 0;
-
-    glGenTextures(1, &font->texture);
-    glBindTexture(GL_TEXTURE_2D, font->texture);
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RED,
-                 font->atlas_width, font->atlas_height, 0,
-                 GL_RED, GL_UNSIGNED_BYTE, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    /* Create shader program */
-    font->shader_program = create_text_shader_program();
-    if (!font->shader_program) {
+    font->height = font->ft_size->metrics.height >> 6;
+    font->advance = font->ft_size->metrics.max_advance >> 6;
+    font->ascent = font->ft_size->metrics.ascender >> 6;
+    font->descent = font->ft_size->metrics.descender >> 6;
+
+    /* Share the renderer's atlas: one strike per face, size, mode and
+     * positioning */
+    font->strike = ocfx_atlas_acquire_strike(font->atlas, font->face->id, size, mode,
+                                             subpixel ? OCFX_STRIKE_SUBPIXEL : 0);
+    if (!font->strike) {
+        ocfx_font_destroy(font);
+        return NULL;
+    }
+
+    if (glyph_cache_dir) load_glyph_cache(font);
+
+    return font;
+}
+#endif /* OCFX_NO_FREETYPE */
+
+/* ============================================================================
+ * Public API Implementation
+ * ============================================================================ */
+
+ocfx_font_t* ocfx_font_load(ocfx_renderer_t *renderer, const char *font_path, int size) {
+#ifdef OCFX_NO_FREETYPE
+    (void)renderer;
+    (void)size;
+    fprintf(stderr, "OCFX: Built without FreeType, cannot load %s\n",
+            font_path ? font_path : "(null)");
+    return NULL;
+#else
+    return load_font(renderer, font_path, size, OCFX_ATLAS_MODE_BITMAP, false);
+#endif
+}
+
+ocfx_font_t* ocfx_font_load_subpixel(ocfx_renderer_t *renderer, const char *font_path,
+                                     int size) {
+#ifdef OCFX_NO_FREETYPE
+    (void)renderer;
+    (void)size;
+    fprintf(stderr, "OCFX: Built without FreeType, cannot load %s\n",
+            font_path ? font_path : "(null)");
+    return NULL;
+#else
+    return load_font(renderer, font_path, size, OCFX_ATLAS_MODE_BITMAP, true);
+#endif
+}
+
+ocfx_font_t* ocfx_font_load_sdf(ocfx_renderer_t *renderer, const char *font_path, int size) {
+#ifdef OCFX_HAVE_FT_SDF
+    return load_font(renderer, font_path, size, OCFX_ATLAS_MODE_SDF, false);
+#else
+    (void)renderer;
+    (void)font_path;
+    (void)size;
+    fprintf(stderr, "OCFX: SDF fonts require FreeType 2.11 or newer\n");
+    return NULL;
+#endif
+}
+
+ocfx_font_t* ocfx_font_load_baked(ocfx_renderer_t *renderer, const char *path) {
+    if (!renderer || !path) return NULL;
+
+    ocfx_font_t *font = calloc(1, sizeof(ocfx_font_t));
+    if (!font) return NULL;
+
+    font->renderer = renderer;
+    font->atlas = ocfx_renderer_get_atlas(renderer);
+    if (!font->atlas) {
+        free(font);
+        return NULL;
+    }
+
+    /* The mapping is used in place: tables and image are never copied */
+    if (!ocfx_strike_map(path, &font->baked)) {
+        fprintf(stderr, "OCFX: Failed to load baked font: %s\n", path);
+        free(font);
+        return NULL;
+    }
+
+    const ocfx_strike_header_t *h = font->baked.header;
+    int max_size = ocfx_atlas_get_max_size(font->atlas);
+    if (h->glyph_count == 0 || h->mode >= OCFX_ATLAS_MODE_COUNT ||
+        (int)h->image_width > max_size || (int)h->image_height > max_size) {
+        fprintf(stderr, "OCFX: Unsupported baked font: %s\n", path);
         ocfx_font_destroy(font);
         return NULL;
     }
 
-    /* Create VAO and VBO */
-    glGenVertexArrays(1, &font->vao);
-    glGenBuffers(1, &font->vbo);
+    font->size = h->size;
+    font->mode = h->mode;
+    font->height = h->height;
+    font->advance = h->advance;
+    font->ascent = h->ascent;
+    font->descent = h->descent;
+
+    font->strike = ocfx_atlas_acquire_strike(font->atlas, next_baked_id++, h->size, h->mode, 0);
+    if (!font->strike || !upload_baked(font)) {
+        ocfx_font_destroy(font);
+        return NULL;
+    }
 
     return font;
 }
 
+bool ocfx_font_is_sdf(ocfx_font_t *font) {
+    return font && font->mode == OCFX_ATLAS_MODE_SDF;
+}
+
+bool ocfx_font_add_fallback(ocfx_font_t *font, ocfx_font_t *fallback) {
+    if (!font || !fallback || fallback == font) return false;
+    if (fallback->atlas != font->atlas || fallback->mode != font->mode ||
+        fallback->subpixel != font->subpixel) {
+        fprintf(stderr, "OCFX: Fallback font must share the renderer, mode and positioning\n");
+        return false;
+    }
+
+#ifndef OCFX_NO_FREETYPE
+    if (!fallback->baked.data && !ocfx_face_load_coverage(fallback->face)) return false;
+#endif
+
+    ocfx_font_t **fallbacks = realloc(font->fallbacks,
+                                      (font->fallback_count + 1) * sizeof(ocfx_font_t *));
+    if (!fallbacks) return false;
+    fallbacks[font->fallback_count++] = fallback;
+    font->fallbacks = fallbacks;
+
+    font->ascii_ready = false;
+    font->numeric_complete = false;
+    return true;
+}
+
+#ifndef OCFX_NO_FREETYPE
+/* Families tried for the generic names, in order */
+static const char *const generic_monospace[] = {
+    "DejaVu Sans Mono", "Liberation Mono", "Noto Sans Mono", "Source Code Pro", NULL
+};
+static const char *const generic_sans[] = {
+    "DejaVu Sans", "Liberation Sans", "Noto Sans", "Cantarell", NULL
+};
+static const char *const generic_serif[] = {
+    "DejaVu Serif", "Liberation Serif", "Noto Serif", NULL
+};
+#endif
+
+bool ocfx_font_find_system(const char *font_name, char *path, size_t path_size) {
+    if (!font_name || !path || path_size == 0) return false;
+
+#ifdef OCFX_NO_FREETYPE
+    return false;
+#else
+    /* "Family" or "Family:Style" */
+    char family[256];
+    const char *colon = strchr(font_name, ':');
+    size_t len = colon ? (size_t)(colon - font_name) : strlen(font_name);
+    if (len == 0 || len >= sizeof(family)) return false;
+    memcpy(family, font_name, len);
+    family[len] = '\0';
+    const char *style = colon && colon[1] ? colon + 1 : NULL;
+
+    const char *const *generic = NULL;
+    if (strcmp(family, "monospace") == 0 || strcmp(family, "mono") == 0) {
+        generic = generic_monospace;
+    } else if (strcmp(family, "sans-serif") == 0 || strcmp(family, "sans") == 0) {
+        generic = generic_sans;
+    } else if (strcmp(family, "serif") == 0) {
+        generic = generic_serif;
+    }
+
+    if (!generic) return ocfx_font_index_find(family, style, path, path_size);
+    for (size_t i = 0; generic[i]; i++) {
+        if (ocfx_font_index_find(generic[i], style, path, path_size)) return true;
+    }
+    return false;
+#endif
+}
+
 ocfx_font_t* ocfx_font_load_system(ocfx_renderer_t *renderer, const char *font_name, int size) {
-    (void)font_name;  /* TODO: Search system font directories */
+    char path[4096];
+    if (font_name && ocfx_font_find_system(font_name, path, sizeof(path))) {
+        ocfx_font_t *font = ocfx_font_load(renderer, path, size);
+        if (font) return font;
+    }
 
-    /* Try common monospace fonts */
+    /* Not installed (or no index): try common monospace fonts */
     const char *font_paths[] = {
         "/usr/share/fonts/TTF/DejaVuSansMono.ttf",
         "/usr/share/fonts/truetype/dejavu/DejaVuSansMono.ttf",
@@ -358,20 +890,165 @@ ocfx_font_t* ocfx_font_load_system(ocfx_renderer_t *renderer, const char *font_n
     return NULL;
 }
 
+/* Drop every cached run and the cache itself */
+static void free_run_cache(ocfx_font_t *font) {
+    size_t entries = font->run_cache_sets * OCFX_RUN_CACHE_WAYS;
+    for (size_t i = 0; i < entries; i++) {
+        ocfx_text_run_destroy(font->run_cache[i].run);
+        free(font->run_cache[i].text);
+    }
+    free(font->run_cache);
+    free(font->run_seen);
+    font->run_cache = NULL;
+    font->run_seen = NULL;
+    font->run_cache_sets = 0;
+}
+
 void ocfx_font_destroy(ocfx_font_t *font) {
     if (!font) return;
 
-    if (font->vbo) glDeleteBuffers(1, &font->vbo);
-    if (font->vao) glDeleteVertexArrays(1, &font->vao);
-    if (font->shader_program) glDeleteProgram(font->shader_program);
-    if (font->texture) glDeleteTextures(1, &font->texture);
-    if (font->glyph_cache) free(font->glyph_cache);
-    if (font->ft_face) FT_Done_Face(font->ft_face);
-    if (font->ft_library) FT_Done_FreeType(font->ft_library);
+#ifndef OCFX_NO_FREETYPE
+    /* Workers read the face mapping: they must be done with this font */
+    if (font->face) ocfx_raster_cancel(font, font->face->id);
+#endif
+
+    if (font->cache_path) {
+        ocfx_font_save_cache(font);
+        ocfx_strike_unmap(&font->cache_file);
+        ocfx_strike_builder_free(&font->cache_builder);
+        free(font->cache_path);
+    }
+
+    free_run_cache(font);
+    ocfx_text_run_destroy(font->scratch);
+    free(font->numeric);
+    free(font->fallbacks);
+    for (int i = 0; i < OCFX_WRAP_CACHE_SIZE; i++) {
+        ocfx_text_layout_destroy(font->wrap_cache[i].layout);
+        free(font->wrap_cache[i].text);
+    }
+    if (font->strike) ocfx_atlas_release_strike(font->atlas, font->strike);
+    ocfx_strike_unmap(&font->baked);
+#ifndef OCFX_NO_FREETYPE
+    free(font->pending);
+    if (font->advance_pages) {
+        size_t pages = ((size_t)font->ft_face->num_glyphs + OCFX_ADVANCE_PAGE - 1) /
+                       OCFX_ADVANCE_PAGE;
+        for (size_t i = 0; i < pages; i++) free(font->advance_pages[i]);
+        free(font->advance_pages);
+    }
+    if (font->ft_size) FT_Done_Size(font->ft_size);
+    ocfx_face_release(font->face);
+#endif
 
     free(font);
 }
 
+bool ocfx_text_set_glyph_loading(ocfx_glyph_loading_t mode, int workers) {
+#ifdef OCFX_NO_FREETYPE
+    (void)workers;
+    glyph_loading = OCFX_GLYPH_SYNC;
+    return mode == OCFX_GLYPH_SYNC;
+#else
+    if (mode == OCFX_GLYPH_SYNC) {
+        ocfx_raster_stop();
+        glyph_loading = mode;
+        return true;
+    }
+
+    if (workers <= 0) {
+        /* Leave a core for the render thread */
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        workers = cores > 1 ? (int)cores - 1 : 1;
+    }
+    if (!ocfx_raster_start(workers)) {
+        glyph_loading = OCFX_GLYPH_SYNC;
+        return false;
+    }
+    glyph_loading = mode;
+    return true;
+#endif
+}
+
+void ocfx_font_prewarm(ocfx_font_t *font, const ocfx_codepoint_range_t *ranges, size_t count) {
+    if (!font || !ranges || font->baked.data) return;  /* Baked fonts are always warm */
+
+#ifndef OCFX_NO_FREETYPE
+    bool async = glyph_loading != OCFX_GLYPH_SYNC && ocfx_raster_running();
+    for (size_t r = 0; r < count; r++) {
+        for (uint32_t cp = ranges[r].first; cp <= ranges[r].last && cp != 0xFFFFFFFFu; cp++) {
+            uint32_t glyph_index;
+            ocfx_font_t *target = resolve_codepoint(font, cp, &glyph_index);
+            if (!glyph_index || target->baked.data) continue;
+
+            for (uint32_t phase = 0; phase < glyph_phases(target); phase++) {
+                uint64_t key = phase_key(target, glyph_index, phase);
+                if (ocfx_atlas_find(target->atlas, key)) continue;
+
+                if (async) {
+                    request_glyph(target, glyph_index, key, false);
+                } else {
+                    cache_glyph(target, glyph_index, key);
+                }
+            }
+        }
+    }
+#else
+    (void)count;
+#endif
+}
+
+void ocfx_text_set_cache_dir(const char *dir) {
+    free(glyph_cache_dir);
+    glyph_cache_dir = (dir && *dir) ? strdup(dir) : NULL;
+}
+
+bool ocfx_font_save_cache(ocfx_font_t *font) {
+    if (!font || !font->cache_path) return false;
+    if (!font->cache_dirty) return true;
+
+#ifdef OCFX_NO_FREETYPE
+    return false;
+#else
+    /* Single level only; a missing parent is a configuration error */
+    const char *slash = strrchr(font->cache_path, '/');
+    if (slash) {
+        size_t dir_len = (size_t)(slash - font->cache_path);
+        char *dir = strndup(font->cache_path, dir_len);
+        if (dir) {
+            mkdir(dir, 0755);
+            free(dir);
+        }
+    }
+
+    ocfx_strike_header_t info = {
+        .face_hash = ocfx_face_hash(font->face),
+        .size = font->size,
+        .mode = font->mode,
+        .height = font->height,
+        .advance = font->advance,
+        .ascent = font->ascent,
+        .descent = font->descent,
+    };
+    if (!ocfx_strike_builder_write(&font->cache_builder, font->cache_path, &info)) {
+        fprintf(stderr, "OCFX: Failed to write glyph cache: %s\n", font->cache_path);
+        return false;
+    }
+
+    font->cache_dirty = false;
+    return true;
+#endif
+}
+
+void ocfx_text_set_atlas_limit(ocfx_renderer_t *renderer, size_t max_bytes) {
+    ocfx_atlas_set_limit(ocfx_renderer_get_atlas(renderer), max_bytes);
+}
+
+void ocfx_text_set_frame_budget(ocfx_renderer_t *renderer, size_t max_bytes, float max_ms) {
+    uint64_t max_ns = max_ms > 0.0f ? (uint64_t)(max_ms * 1e6f) : 0;
+    ocfx_atlas_set_budget(ocfx_renderer_get_atlas(renderer), max_bytes, max_ns);
+}
+
 /* Font metrics */
 int ocfx_font_get_height(ocfx_font_t *font) {
     return font ? font->height : 0;
@@ -390,6 +1067,62 @@ int ocfx_font_get_descent(ocfx_font_t *font) {
 }
 
 /* Text measurement */
+/* Decode the next chunk of the view [*text, end). NUL bytes inside a
+ * bounded view (slices of binary buffers) are skipped instead of ending
+ * it; a malformed sequence still ends the text. */
+static size_t decode_span(const char **text, const char *end, uint32_t *codepoints) {
+    size_t n;
+    while ((n = ocfx_utf8_decode(text, end, codepoints, OCFX_DECODE_CHUNK)) == 0 &&
+           *text < end && **text == '\0') {
+        (*text)++;
+    }
+    return n;
+}
+
+/* Walk [text, end) like decode_span (NULs skipped, a malformed sequence
+ * ends it), with ASCII advances read straight from the font's table.
+ * With prefix, records the pen position before each of up to max
+ * codepoints; returns the codepoints visited and the width in *width. */
+static size_t advance_span(ocfx_font_t *font, const char *text, const char *end,
+                           float *prefix, size_t max, float *width) {
+    const float *ascii = ascii_advances(font);
+    const uint8_t *s = (const uint8_t *)text;
+    const uint8_t *e = (const uint8_t *)end;
+    float pen = 0.0f;
+    size_t count = 0;
+
+    while (s < e && count < max) {
+        if (*s < 0x80) {
+            if (*s) {
+                if (prefix) prefix[count] = pen;
+                pen += ascii[*s];
+                count++;
+            }
+            s++;
+            continue;
+        }
+
+        const char *p = (const char *)s;
+        uint32_t codepoint;
+        if (ocfx_utf8_decode(&p, end, &codepoint, 1) == 0) break;
+        if (prefix) prefix[count] = pen;
+        pen += codepoint_advance(font, codepoint);
+        count++;
+        s = (const uint8_t *)p;
+    }
+
+    if (prefix) prefix[count] = pen;
+    *width = pen;
+    return count;
+}
+
+/* Sum of advances over [text, end) */
+static float measure_span(ocfx_font_t *font, const char *text, const char *end) {
+    float w;
+    advance_span(font, text, end, NULL, SIZE_MAX, &w);
+    return w;
+}
+
 void ocfx_text_measure(ocfx_font_t *font, const char *text, float *width, float *height) {
     if (!font || !text) {
         if (width) *width = 0;
@@ -397,19 +1130,7 @@ void ocfx_text_measure(ocfx_font_t *font, const char *text, float *width, float
         return;
     }
 
-    float w = 0;
-    const char *p = text;
-    while (*p) {
-        uint32_t codepoint = utf8_decode(&p);
-        if (codepoint == 0) break;
-
-        glyph_cache_entry_t *glyph = get_glyph(font, codepoint);
-        if (glyph) {
-            w += glyph->advance;
-        }
-    }
-
-    if (width) *width = w;
+    if (width) *width = measure_span(font, text, text + strlen(text));
     if (height) *height = (float)font->height;
 }
 
@@ -421,187 +1142,1308 @@ void ocfx_text_measure_n(ocfx_font_t *font, const char *text, size_t len,
         return;
     }
 
-    float w = 0;
-    const char *p = text;
-    const char *end = text + len;
-    while (p < end && *p) {
-        uint32_t codepoint = utf8_decode(&p);
-        if (codepoint == 0) break;
+    if (width) *width = measure_span(font, text, text + len);
+    if (height) *height = (float)font->height;
+}
 
-        glyph_cache_entry_t *glyph = get_glyph(font, codepoint);
-        if (glyph) {
-            w += glyph->advance;
+float ocfx_text_measure_batch(ocfx_font_t *font, const char *const *texts,
+                              const size_t *lens, size_t count, float *widths) {
+    float widest = 0.0f;
+    if (!font || !texts) return widest;
+
+    for (size_t i = 0; i < count; i++) {
+        float w = 0.0f;
+        if (texts[i]) {
+            size_t len = lens ? lens[i] : strlen(texts[i]);
+            advance_span(font, texts[i], texts[i] + len, NULL, SIZE_MAX, &w);
         }
+        if (widths) widths[i] = w;
+        if (w > widest) widest = w;
     }
-
-    if (width) *width = w;
-    if (height) *height = (float)font->height;
+    return widest;
 }
 
-/* Text rendering */
-void ocfx_text_draw(ocfx_renderer_t *renderer, ocfx_font_t *font,
-                    const char *text, float x, float y, ocfx_color_t color) {
-    if (!renderer || !font || !text) return;
+size_t ocfx_text_prefix_advances(ocfx_font_t *font, const char *text, size_t len,
+                                 float *prefix, size_t max) {
+    if (!prefix) return 0;
+    if (!font || !text) {
+        prefix[0] = 0.0f;
+        return 0;
+    }
 
-    /* Get viewport for shader uniform */
-    int32_t vp_width, vp_height;
-    ocfx_render_get_viewport(renderer, &vp_width, &vp_height);
+    float width;
+    return advance_span(font, text, text + len, prefix, max, &width);
+}
 
-    glUseProgram(font->shader_program);
+size_t ocfx_text_hit_test(const float *prefix, size_t count, float x) {
+    if (!prefix) return 0;
 
-    /* Set uniforms */
-    GLint u_resolution = glGetUniformLocation(font->shader_program, "u_resolution");
-    glUniform2f(u_resolution, (float)vp_width, (float)vp_height);
+    /* First codepoint whose midpoint lies right of x: the caret goes before it */
+    size_t lo = 0, hi = count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if ((prefix[mid] + prefix[mid + 1]) * 0.5f <= x) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
 
-    GLint u_texture = glGetUniformLocation(font->shader_program, "u_texture");
-    glUniform1i(u_texture, 0);
+/* Text rendering */
+#ifndef OCFX_NO_FREETYPE
+/* Queue a job for every codepoint whose glyph is not in the atlas */
+static bool request_missing(ocfx_font_t *font, const uint32_t *codepoints, size_t count) {
+    bool requested = false;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t glyph_index;
+        ocfx_font_t *target = resolve_codepoint(font, codepoints[i], &glyph_index);
+        if (target->baked.data) continue;
+
+        /* Every phase: where the pen lands is only known when drawing */
+        for (uint32_t phase = 0; phase < glyph_phases(target); phase++) {
+            uint64_t key = phase_key(target, glyph_index, phase);
+            if (!ocfx_atlas_find(target->atlas, key)) {
+                request_glyph(target, glyph_index, key, true);
+                requested = true;
+            }
+        }
+    }
+    return requested;
+}
 
-    /* Bind texture */
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, font->texture);
+/* Wait for the draw requests of the font and of its fallbacks (not for
+ * their prewarm backlog) */
+static void wait_glyphs(ocfx_font_t *font) {
+    ocfx_raster_wait_urgent(font);
+    for (size_t i = 0; i < font->fallback_count; i++) {
+        ocfx_raster_wait_urgent(font->fallbacks[i]);
+    }
+}
 
-    /* Render each character */
-    /* Y coordinate is treated as TOP of text, convert to baseline
-     * In screen space: (0,0) is top-left, Y increases downward
-     * ascent is positive, represents pixels above baseline
-     * So baseline = top + ascent */
-    float pen_x = x;
-    float pen_y = y + (float)font->ascent;
+/* Queue every missing glyph of text at once and wait for the batch, so
+ * a burst of new glyphs is rasterized by all workers in parallel */
+static void prefetch_text(ocfx_font_t *font, const char *text, const char *end) {
+    uint32_t codepoints[OCFX_DECODE_CHUNK];
+    bool requested = false;
+    size_t n;
+    while ((n = decode_span(&text, end, codepoints)) > 0) {
+        requested |= request_missing(font, codepoints, n);
+    }
+
+    if (requested) {
+        wait_glyphs(font);
+        collect_glyphs(NULL);
+    }
+}
+#endif
+
+/* Bring finished background glyphs in before looking up codepoints; in
+ * WAIT mode, also queue the missing ones and block until they are ready */
+static void prepare_codepoints(ocfx_font_t *font, const uint32_t *codepoints, size_t count) {
+#ifdef OCFX_NO_FREETYPE
+    (void)font;
+    (void)codepoints;
+    (void)count;
+#else
+    if (glyph_loading != OCFX_GLYPH_SYNC && ocfx_raster_running()) {
+        collect_glyphs(glyph_loading == OCFX_GLYPH_WAIT ? NULL : font->atlas);
+        if (glyph_loading == OCFX_GLYPH_WAIT && !font->baked.data &&
+            request_missing(font, codepoints, count)) {
+            wait_glyphs(font);
+            collect_glyphs(NULL);
+        }
+    }
+#endif
+}
+
+/* Draw prelude: bring finished background glyphs in; in WAIT mode, also
+ * rasterize the ones [text, end) is missing before it is drawn */
+static void prepare_text(ocfx_font_t *font, const char *text, const char *end) {
+#ifdef OCFX_NO_FREETYPE
+    (void)font;
+    (void)text;
+    (void)end;
+#else
+    if (glyph_loading != OCFX_GLYPH_SYNC && ocfx_raster_running()) {
+        collect_glyphs(glyph_loading == OCFX_GLYPH_WAIT ? NULL : font->atlas);
+        if (glyph_loading == OCFX_GLYPH_WAIT && !font->baked.data) {
+            prefetch_text(font, text, end);
+        }
+    }
+#endif
+}
+
+/* Shared draw loop over text[0, len); a NULL transform takes the
+ * untransformed fast path. Reads the view in place: no copy, no malloc. */
+static void draw_text(ocfx_font_t *font, const char *text, size_t len, float x, float y,
+                      const ocfx_transform_t *transform, ocfx_color_t color) {
+    /* Glyph quads go into the renderer's batch; consecutive draws (even
+     * with different fonts) share one draw call */
+    ocfx_rgba8_t rgba = ocfx_atlas_pack_color(color);
+
+    /* Y coordinate is treated as TOP of text, convert to baseline
+     * In screen space: (0,0) is top-left, Y increases downward
+     * ascent is positive, represents pixels above baseline
+     * So baseline = top + ascent */
+    float pen_x = x;
+    float pen_y = y + (float)font->ascent;
+    const char *end = text + len;
+
+    prepare_text(font, text, end);
+
+    /* Decode in bulk, then look glyphs up from the codepoint array */
+    uint32_t codepoints[OCFX_DECODE_CHUNK];
+    size_t n;
+    while ((n = decode_span(&text, end, codepoints)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            ocfx_glyph_t *glyph;
+            if (transform) {
+                glyph = get_glyph(font, codepoints[i]);
+                if (!glyph) continue;
+                ocfx_atlas_push_glyph_transformed(font->atlas, glyph, pen_x, pen_y,
+                                                  transform, rgba);
+            } else {
+                float quad_x;
+                glyph = glyph_at(font, codepoints[i], pen_x, &quad_x);
+                if (!glyph) continue;
+                ocfx_atlas_push_glyph(font->atlas, glyph, quad_x, pen_y, rgba);
+            }
+            pen_x += glyph->advance;
+        }
+    }
+}
+
+/* ============================================================================
+ * Prepared text runs
+ * ============================================================================ */
+
+/* Quads of one atlas page and mode, drawn with one batch reserve */
+typedef struct {
+    uint32_t page;
+    uint32_t mode;
+    size_t first;                 /* First quad */
+    size_t count;
+} run_span_t;
+
+/* Prepared run: quads laid out once relative to the top-left corner,
+ * replayed by offsetting positions and setting the color */
+struct ocfx_text_run_t {
+    ocfx_font_t *font;
+    uint32_t *codepoints;         /* Kept to rebuild after atlas eviction */
+    size_t count;
+    size_t capacity;              /* Codepoints (and quads) there is room for */
+    ocfx_text_vertex_t *vertices; /* Four per quad, at most one quad per codepoint */
+    size_t quad_count;
+    run_span_t *spans;
+    size_t span_count;
+    float width;
+    uint32_t generation;          /* Atlas generation the quads point into */
+    bool complete;                /* False while placeholders stand in for glyphs */
+};
+
+static bool is_placeholder(ocfx_font_t *font, const ocfx_glyph_t *glyph) {
+#ifdef OCFX_NO_FREETYPE
+    (void)font;
+    (void)glyph;
+    return false;
+#else
+    if (glyph == &font->placeholder) return true;
+    for (size_t i = 0; i < font->fallback_count; i++) {
+        if (glyph == &font->fallbacks[i]->placeholder) return true;
+    }
+    return false;
+#endif
+}
+
+/* Lay the run's glyphs out again from the atlas */
+static void build_run(ocfx_text_run_t *run) {
+    ocfx_font_t *font = run->font;
+
+    prepare_codepoints(font, run->codepoints, run->count);
+
+    /* Glyph misses may evict pages holding quads laid out earlier in this
+     * pass; a second pass finds every glyph cached */
+    for (int attempt = 0; attempt < 2; attempt++) {
+        uint32_t generation = ocfx_atlas_generation(font->atlas);
+        float pen_x = 0.0f;
+        float pen_y = (float)font->ascent;
+
+        run->quad_count = 0;
+        run->span_count = 0;
+        run->complete = true;
+
+        for (size_t i = 0; i < run->count; i++) {
+            float quad_x;
+            ocfx_glyph_t *glyph = glyph_at(font, run->codepoints[i], pen_x, &quad_x);
+            if (!glyph) continue;
+            if (is_placeholder(font, glyph)) run->complete = false;
+
+            if (glyph->width > 0 && glyph->height > 0) {
+                run_span_t *span = run->span_count ? &run->spans[run->span_count - 1] : NULL;
+                if (!span || span->page != glyph->page || span->mode != glyph->mode) {
+                    span = &run->spans[run->span_count++];
+                    *span = (run_span_t){glyph->page, glyph->mode, run->quad_count, 0};
+                }
+                span->count++;
+
+                float x0 = quad_x + glyph->bearing_x;
+                float y0 = pen_y - glyph->bearing_y;
+                float x1 = x0 + glyph->width;
+                float y1 = y0 + glyph->height;
+                float tx0 = glyph->atlas_x;
+                float ty0 = glyph->atlas_y;
+                float tx1 = tx0 + glyph->width;
+                float ty1 = ty0 + glyph->height;
+
+                ocfx_text_vertex_t *v = &run->vertices[run->quad_count++ * 4];
+                v[0] = (ocfx_text_vertex_t){x0, y0, tx0, ty0, 0, 0, 0, 0};
+                v[1] = (ocfx_text_vertex_t){x1, y0, tx1, ty0, 0, 0, 0, 0};
+                v[2] = (ocfx_text_vertex_t){x0, y1, tx0, ty1, 0, 0, 0, 0};
+                v[3] = (ocfx_text_vertex_t){x1, y1, tx1, ty1, 0, 0, 0, 0};
+            }
+            pen_x += glyph->advance;
+        }
+
+        run->width = pen_x;
+        run->generation = generation;
+        if (ocfx_atlas_generation(font->atlas) == generation) return;
+    }
+
+    /* Still moving: rebuild on the next draw */
+    run->complete = false;
+}
+
+/* Copy the run's quads into the batch at (x, y) */
+static void draw_run(ocfx_text_run_t *run, float x, float y, ocfx_rgba8_t color) {
+    ocfx_atlas_t *atlas = run->font->atlas;
+    if (!run->complete || run->generation != ocfx_atlas_generation(atlas)) {
+        build_run(run);
+    }
+
+    /* Phases were picked for a run starting on a whole pixel */
+    if (run->font->subpixel) x = floorf(x + 0.5f);
+
+    for (size_t s = 0; s < run->span_count; s++) {
+        const run_span_t *span = &run->spans[s];
+        ocfx_atlas_touch_page(atlas, span->page);
+
+        const ocfx_text_vertex_t *src = &run->vertices[span->first * 4];
+        size_t left = span->count;
+        while (left > 0) {
+            size_t quads = left < OCFX_TEXT_BATCH_QUADS ? left : OCFX_TEXT_BATCH_QUADS;
+            ocfx_text_vertex_t *dst = ocfx_atlas_batch_reserve(atlas, span->page, span->mode,
+                                                               quads);
+            for (size_t i = 0; i < quads * 4; i++) {
+                dst[i] = (ocfx_text_vertex_t){src[i].x + x, src[i].y + y, src[i].u, src[i].v,
+                                              color.r, color.g, color.b, color.a};
+            }
+            src += quads * 4;
+            left -= quads;
+        }
+    }
+}
+
+/* Decode text into the run and lay it out. Storage only ever grows, so
+ * a reused run stops allocating once it has seen its longest string. */
+static bool run_set_text(ocfx_text_run_t *run, const char *text, size_t len) {
+    /* Codepoints never outnumber bytes, so decoding cannot overrun */
+    size_t needed = len ? len : 1;
+    if (needed > run->capacity) {
+        uint32_t *codepoints = realloc(run->codepoints, needed * sizeof(uint32_t));
+        if (codepoints) run->codepoints = codepoints;
+        ocfx_text_vertex_t *vertices = realloc(run->vertices,
+                                               needed * 4 * sizeof(ocfx_text_vertex_t));
+        if (vertices) run->vertices = vertices;
+        run_span_t *spans = realloc(run->spans, needed * sizeof(run_span_t));
+        if (spans) run->spans = spans;
+        if (!codepoints || !vertices || !spans) return false;
+        run->capacity = needed;
+    }
 
     const char *p = text;
-    while (*p) {
-        uint32_t codepoint = utf8_decode(&p);
-        if (codepoint == 0) break;  /* End of string or error */
+    const char *end = text + len;
+    size_t n;
+    run->count = 0;
+    while ((n = decode_span(&p, end, run->codepoints + run->count)) > 0) {
+        run->count += n;
+    }
+
+    build_run(run);
+    return true;
+}
+
+ocfx_text_run_t* ocfx_text_run_create(ocfx_font_t *font, const char *text, size_t len) {
+    if (!font || !text) return NULL;
+
+    ocfx_text_run_t *run = calloc(1, sizeof(ocfx_text_run_t));
+    if (!run) return NULL;
+    run->font = font;
+
+    if (!run_set_text(run, text, len)) {
+        ocfx_text_run_destroy(run);
+        return NULL;
+    }
+    return run;
+}
 
-        glyph_cache_entry_t *glyph = get_glyph(font, codepoint);
-        if (!glyph) continue;
+void ocfx_text_run_destroy(ocfx_text_run_t *run) {
+    if (!run) return;
+    free(run->codepoints);
+    free(run->vertices);
+    free(run->spans);
+    free(run);
+}
 
-        float x0 = pen_x + glyph->bearing_x;
-        float y0 = pen_y - glyph->bearing_y;
-        float x1 = x0 + glyph->width;
-        float y1 = y0 + glyph->height;
+void ocfx_text_run_measure(ocfx_text_run_t *run, float *width, float *height) {
+    if (width) *width = run ? run->width : 0;
+    if (height) *height = run ? (float)run->font->height : 0;
+}
+
+void ocfx_text_run_draw(ocfx_renderer_t *renderer, ocfx_text_run_t *run,
+                        float x, float y, ocfx_color_t color) {
+    if (!renderer || !run) return;
+    draw_run(run, x, y, ocfx_atlas_pack_color(color));
+}
+
+/* Automatic run cache: OCFX_RUN_CACHE_WAYS entries per set, picked by
+ * string hash, least recently drawn entry replaced. A string becomes a run
+ * only on its second sighting: each set also remembers the hashes of the
+ * last OCFX_RUN_CACHE_WAYS strings seen once, so text that changes every
+ * frame does not churn the cache while labels sharing a set still get in. */
+void ocfx_font_set_run_cache(ocfx_font_t *font, size_t max_runs) {
+    if (!font) return;
+    free_run_cache(font);
+    if (max_runs == 0) return;
+
+    size_t sets = 1;
+    while (sets * OCFX_RUN_CACHE_WAYS < max_runs) sets *= 2;
+
+    font->run_cache = calloc(sets * OCFX_RUN_CACHE_WAYS, sizeof(run_cache_entry_t));
+    font->run_seen = calloc(sets * OCFX_RUN_CACHE_WAYS, sizeof(uint64_t));
+    if (!font->run_cache || !font->run_seen) {
+        free(font->run_cache);
+        free(font->run_seen);
+        font->run_cache = NULL;
+        font->run_seen = NULL;
+        return;
+    }
+    font->run_cache_sets = sets;
+}
 
-        float tx0 = glyph->atlas_x;
-        float ty0 = glyph->atlas_y;
-        float tx1 = tx0 + glyph->atlas_width;
-        float ty1 = ty0 + glyph->atlas_height;
+/* Cached run for text[0, len), or NULL to draw it directly */
+static ocfx_text_run_t* cached_run(ocfx_font_t *font, const char *text, size_t len) {
+    uint64_t hash = ocfx_strike_hash((const uint8_t *)text, len);
+    size_t set = (size_t)hash & (font->run_cache_sets - 1);
+    run_cache_entry_t *ways = &font->run_cache[set * OCFX_RUN_CACHE_WAYS];
+    uint64_t frame = ocfx_render_get_frame(font->renderer);
+
+    run_cache_entry_t *victim = &ways[0];
+    for (int i = 0; i < OCFX_RUN_CACHE_WAYS; i++) {
+        run_cache_entry_t *entry = &ways[i];
+        if (entry->run && entry->hash == hash && entry->len == len &&
+            memcmp(entry->text, text, len) == 0) {
+            entry->last_used = frame;
+            return entry->run;
+        }
+        if (victim->run && (!entry->run || entry->last_used < victim->last_used)) {
+            victim = entry;
+        }
+    }
 
-        /* Vertex data: pos(x,y) + texcoord(u,v) + color(r,g,b,a) */
-        float vertices[] = {
-            x0, y0, tx0, ty0, color.r, color.g, color.b, color.a,
-            x1, y0, tx1, ty0, color.r, color.g, color.b, color.a,
-            x0, y1, tx0, ty1, color.r, color.g, color.b, color.a,
+    /* First sighting: remember it, newest first, dropping the oldest */
+    uint64_t *seen = &font->run_seen[set * OCFX_RUN_CACHE_WAYS];
+    int found = -1;
+    for (int i = 0; i < OCFX_RUN_CACHE_WAYS; i++) {
+        if (seen[i] == hash) {
+            found = i;
+            break;
+        }
+    }
+    if (found < 0) {
+        memmove(seen + 1, seen, (OCFX_RUN_CACHE_WAYS - 1) * sizeof(uint64_t));
+        seen[0] = hash;
+        return NULL;
+    }
+    memmove(seen + found, seen + found + 1,
+            (size_t)(OCFX_RUN_CACHE_WAYS - 1 - found) * sizeof(uint64_t));
+    seen[OCFX_RUN_CACHE_WAYS - 1] = 0;
+
+    char *copy = malloc(len ? len : 1);
+    ocfx_text_run_t *run = copy ? ocfx_text_run_create(font, text, len) : NULL;
+    if (!run) {
+        free(copy);
+        return NULL;
+    }
+    memcpy(copy, text, len);
 
-            x1, y0, tx1, ty0, color.r, color.g, color.b, color.a,
-            x1, y1, tx1, ty1, color.r, color.g, color.b, color.a,
-            x0, y1, tx0, ty1, color.r, color.g, color.b, color.a,
-        };
+    ocfx_text_run_destroy(victim->run);
+    free(victim->text);
+    *victim = (run_cache_entry_t){hash, frame, len, copy, run};
+    return run;
+}
 
-        glBindVertexArray(font->vao);
-        glBindBuffer(GL_ARRAY_BUFFER, font->vbo);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_DYNAMIC_DRAW);
+/* Untransformed draw, through the run cache when the font has one */
+static void draw_plain(ocfx_font_t *font, const char *text, size_t len, float x, float y,
+                       ocfx_color_t color) {
+    ocfx_text_run_t *run = font->run_cache ? cached_run(font, text, len) : NULL;
+    if (run) {
+        draw_run(run, x, y, ocfx_atlas_pack_color(color));
+    } else {
+        draw_text(font, text, len, x, y, NULL, color);
+    }
+}
 
-        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(2 * sizeof(float)));
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(4 * sizeof(float)));
-        glEnableVertexAttribArray(2);
+void ocfx_text_draw(ocfx_renderer_t *renderer, ocfx_font_t *font,
+                    const char *text, float x, float y, ocfx_color_t color) {
+    if (!renderer || !font || !text) return;
+    draw_plain(font, text, strlen(text), x, y, color);
+}
 
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+void ocfx_text_draw_scaled(ocfx_renderer_t *renderer, ocfx_font_t *font,
+                           const char *text, float x, float y, float scale,
+                           ocfx_color_t color) {
+    if (!renderer || !font || !text) return;
 
-        pen_x += glyph->advance;
+    if (scale == 1.0f) {
+        draw_plain(font, text, strlen(text), x, y, color);
+    } else {
+        ocfx_transform_t transform = OCFX_TRANSFORM_SCALE(scale, x, y);
+        draw_text(font, text, strlen(text), 0.0f, 0.0f, &transform, color);
     }
+}
 
-    glBindVertexArray(0);
+void ocfx_text_draw_transformed(ocfx_renderer_t *renderer, ocfx_font_t *font,
+                                const char *text, ocfx_transform_t transform,
+                                ocfx_color_t color) {
+    if (!renderer || !font || !text) return;
+    draw_text(font, text, strlen(text), 0.0f, 0.0f, &transform, color);
 }
 
 void ocfx_text_draw_n(ocfx_renderer_t *renderer, ocfx_font_t *font,
                       const char *text, size_t len, float x, float y, ocfx_color_t color) {
     if (!renderer || !font || !text) return;
+    draw_plain(font, text, len, x, y, color);
+}
+
+/* ============================================================================
+ * Rich text
+ * ============================================================================ */
+
+/* Stretch of text with one style: a span or a gap between spans */
+typedef struct {
+    size_t start;
+    size_t end;
+    ocfx_font_t *font;
+    ocfx_rgba8_t color;
+    ocfx_rgba8_t background;
+} style_segment_t;
+
+/* Next segment from *pos on, stepping *index through the spans. Spans
+ * that overlap earlier ones are cut to start at *pos. */
+static bool next_segment(ocfx_font_t *font, size_t len, const ocfx_text_span_t *spans,
+                         size_t span_count, ocfx_rgba8_t color,
+                         size_t *pos, size_t *index, style_segment_t *seg) {
+    if (*pos >= len) return false;
+
+    /* Skip spans that are empty, past the text or already drawn */
+    while (*index < span_count) {
+        const ocfx_text_span_t *span = &spans[*index];
+        if (span->start < len && span->len > 0 &&
+            (span->start > *pos || span->len > *pos - span->start)) break;
+        (*index)++;
+    }
+
+    *seg = (style_segment_t){*pos, len, font, color, {0, 0, 0, 0}};
+    if (*index < span_count) {
+        const ocfx_text_span_t *span = &spans[*index];
+        if (span->start > *pos) {
+            seg->end = span->start;
+        } else {
+            if (span->len < len - span->start) seg->end = span->start + span->len;
+            if (span->font) seg->font = span->font;
+            seg->color = ocfx_atlas_pack_color(span->color);
+            seg->background = ocfx_atlas_pack_color(span->background);
+            (*index)++;
+        }
+    }
+    *pos = seg->end;
+    return true;
+}
+
+void ocfx_text_draw_spans(ocfx_renderer_t *renderer, ocfx_font_t *font,
+                          const char *text, size_t len,
+                          const ocfx_text_span_t *spans, size_t span_count,
+                          float x, float y, ocfx_color_t color) {
+    if (!renderer || !font || !text) return;
+    if (!spans) span_count = 0;
+
+    ocfx_rgba8_t rgba = ocfx_atlas_pack_color(color);
+    style_segment_t seg;
+    size_t pos, index;
+
+    /* Backgrounds first, measured from the advance tables, so glyphs
+     * overhanging into the next span are not covered by its background */
+    float pen_x = x;
+    pos = index = 0;
+    while (next_segment(font, len, spans, span_count, rgba, &pos, &index, &seg)) {
+        float width;
+        advance_span(seg.font, text + seg.start, text + seg.end, NULL, SIZE_MAX, &width);
+        if (seg.background.a) {
+            ocfx_atlas_push_rect(font->atlas, font->mode, pen_x, y, pen_x + width,
+                                 y + (float)font->height, seg.background);
+        }
+        pen_x += width;
+    }
+
+    /* Glyphs of every segment on the base font's baseline */
+    pen_x = x;
+    float pen_y = y + (float)font->ascent;
+    pos = index = 0;
+    while (next_segment(font, len, spans, span_count, rgba, &pos, &index, &seg)) {
+        const char *p = text + seg.start;
+        const char *end = text + seg.end;
+        prepare_text(seg.font, p, end);
+
+        uint32_t codepoints[OCFX_DECODE_CHUNK];
+        size_t n;
+        while ((n = decode_span(&p, end, codepoints)) > 0) {
+            for (size_t i = 0; i < n; i++) {
+                float quad_x;
+                ocfx_glyph_t *glyph = glyph_at(seg.font, codepoints[i], pen_x, &quad_x);
+                if (!glyph) continue;
+                ocfx_atlas_push_glyph(seg.font->atlas, glyph, quad_x, pen_y, seg.color);
+                pen_x += glyph->advance;
+            }
+        }
+    }
+}
+
+/* ============================================================================
+ * Numbers
+ * ============================================================================ */
+
+/* Lay out the numeric characters' quads from the atlas (same two-pass
+ * scheme as build_run) */
+static bool build_numeric(ocfx_font_t *font) {
+    if (!font->numeric) {
+        font->numeric = calloc(OCFX_NUMERIC_SLOTS, sizeof(numeric_glyph_t));
+        if (!font->numeric) return false;
+    }
+
+    uint32_t codepoints[OCFX_NUMERIC_SLOTS];
+    for (int i = 0; i < OCFX_NUMERIC_SLOTS; i++) codepoints[i] = (uint8_t)OCFX_NUMERIC_CHARS[i];
+    prepare_codepoints(font, codepoints, OCFX_NUMERIC_SLOTS);
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        uint32_t generation = ocfx_atlas_generation(font->atlas);
+        float pen_y = (float)font->ascent;
+        font->numeric_complete = true;
+        font->digit_width = 0.0f;
+        font->hex_width = 0.0f;
+
+        for (int i = 0; i < OCFX_NUMERIC_SLOTS; i++) {
+            numeric_glyph_t *num = &font->numeric[i];
+            ocfx_glyph_t *glyph = get_glyph(font, codepoints[i]);
+            *num = (numeric_glyph_t){0};
+            if (!glyph) continue;
+            if (is_placeholder(font, glyph)) font->numeric_complete = false;
+
+            num->advance = glyph->advance;
+            if (i < 10 && num->advance > font->digit_width) font->digit_width = num->advance;
+            if (i < 16 && num->advance > font->hex_width) font->hex_width = num->advance;
+
+            if (glyph->width > 0 && glyph->height > 0) {
+                float x0 = glyph->bearing_x;
+                float y0 = pen_y - glyph->bearing_y;
+                float x1 = x0 + glyph->width;
+                float y1 = y0 + glyph->height;
+                float tx0 = glyph->atlas_x;
+                float ty0 = glyph->atlas_y;
+                float tx1 = tx0 + glyph->width;
+                float ty1 = ty0 + glyph->height;
+
+                num->quad[0] = (ocfx_text_vertex_t){x0, y0, tx0, ty0, 0, 0, 0, 0};
+                num->quad[1] = (ocfx_text_vertex_t){x1, y0, tx1, ty0, 0, 0, 0, 0};
+                num->quad[2] = (ocfx_text_vertex_t){x0, y1, tx0, ty1, 0, 0, 0, 0};
+                num->quad[3] = (ocfx_text_vertex_t){x1, y1, tx1, ty1, 0, 0, 0, 0};
+                num->page = glyph->page;
+                num->mode = glyph->mode;
+                num->visible = true;
+            }
+        }
+
+        font->numeric_generation = generation;
+        if (ocfx_atlas_generation(font->atlas) == generation) return true;
+    }
+
+    font->numeric_complete = false;
+    return true;
+}
+
+/* Draw slots[0, count) with digits in tabular cells of the given width;
+ * returns the width drawn */
+static float draw_numeric(ocfx_font_t *font, const uint8_t *slots, size_t count,
+                          float x, float y, float cell, ocfx_rgba8_t color) {
+    ocfx_atlas_t *atlas = font->atlas;
+    uint32_t touched = UINT32_MAX;
+    float pen_x = x;
+
+    for (size_t i = 0; i < count; i++) {
+        const numeric_glyph_t *num = &font->numeric[slots[i]];
+
+        /* Digits are centered in their cell; signs and points keep their
+         * own advance */
+        float width = slots[i] < 16 ? cell : num->advance;
+        if (num->visible) {
+            if (num->page != touched) {
+                ocfx_atlas_touch_page(atlas, num->page);
+                touched = num->page;
+            }
+            float dx = pen_x + (width - num->advance) * 0.5f;
+            /* Quads are phase 0: keep them on whole pixels, as glyph_at does */
+            if (font->subpixel) dx = floorf(dx + 0.5f);
+            ocfx_text_vertex_t *v = ocfx_atlas_batch_reserve(atlas, num->page, num->mode, 1);
+            for (int k = 0; k < 4; k++) {
+                v[k] = (ocfx_text_vertex_t){num->quad[k].x + dx, num->quad[k].y + y,
+                                            num->quad[k].u, num->quad[k].v,
+                                            color.r, color.g, color.b, color.a};
+            }
+        }
+        pen_x += width;
+    }
+    return pen_x - x;
+}
+
+/* Bring the numeric quads up to date with the atlas */
+static bool numeric_ready(ocfx_font_t *font) {
+    if (font->numeric && font->numeric_complete &&
+        font->numeric_generation == ocfx_atlas_generation(font->atlas)) {
+        return true;
+    }
+    return build_numeric(font);
+}
+
+/* Write the decimal digits of value right-aligned into end[-n, 0) with at
+ * least min_digits digits; returns n */
+static size_t format_decimal(uint8_t *end, uint64_t value, int min_digits) {
+    size_t n = 0;
+    do {
+        *--end = (uint8_t)(value % 10);
+        value /= 10;
+        n++;
+    } while (value || (int)n < min_digits);
+    return n;
+}
+
+float ocfx_text_draw_int(ocfx_renderer_t *renderer, ocfx_font_t *font, int64_t value,
+                         float x, float y, ocfx_color_t color) {
+    if (!renderer || !font || !numeric_ready(font)) return 0.0f;
+
+    uint8_t slots[24];
+    uint8_t *end = slots + sizeof(slots);
+    uint64_t magnitude = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+    size_t n = format_decimal(end, magnitude, 1);
+    if (value < 0) slots[sizeof(slots) - ++n] = 16;  /* '-' */
+
+    return draw_numeric(font, end - n, n, x, y, font->digit_width,
+                        ocfx_atlas_pack_color(color));
+}
 
-    /* Simple implementation: copy string and null-terminate */
-    char *temp = malloc(len + 1);
-    if (!temp) return;
+float ocfx_text_draw_fixed(ocfx_renderer_t *renderer, ocfx_font_t *font, double value,
+                           int decimals, float x, float y, ocfx_color_t color) {
+    if (!renderer || !font) return 0.0f;
+    if (decimals < 0) decimals = 0;
+    if (decimals > 9) decimals = 9;
+
+    uint64_t scale = 1;
+    for (int i = 0; i < decimals; i++) scale *= 10;
+    double scaled = fabs(value) * (double)scale + 0.5;
+
+    /* Out of the fast path's range (NaN, infinities, >= 2^63): printf */
+    if (!(scaled < 9223372036854775808.0)) {
+        char text[64];
+        int len = snprintf(text, sizeof(text), "%.*f", decimals, value);
+        float width = 0.0f;
+        if (len > 0) {
+            size_t n = (size_t)len < sizeof(text) ? (size_t)len : sizeof(text) - 1;
+            ocfx_text_measure_n(font, text, n, &width, NULL);
+            draw_plain(font, text, n, x, y, color);
+        }
+        return width;
+    }
+    if (!numeric_ready(font)) return 0.0f;
+
+    uint64_t fixed = (uint64_t)scaled;
+    uint8_t slots[32];
+    uint8_t *end = slots + sizeof(slots);
+    size_t n = 0;
+    if (decimals > 0) {
+        n = format_decimal(end, fixed % scale, decimals);
+        slots[sizeof(slots) - ++n] = 17;  /* '.' */
+    }
+    n += format_decimal(end - n, fixed / scale, 1);
+    if (value < 0.0 && fixed != 0) slots[sizeof(slots) - ++n] = 16;  /* '-' */
 
-    memcpy(temp, text, len);
-    temp[len] = '\0';
+    return draw_numeric(font, end - n, n, x, y, font->digit_width,
+                        ocfx_atlas_pack_color(color));
+}
 
-    ocfx_text_draw(renderer, font, temp, x, y, color);
+float ocfx_text_draw_hex(ocfx_renderer_t *renderer, ocfx_font_t *font, uint64_t value,
+                         int min_digits, float x, float y, ocfx_color_t color) {
+    if (!renderer || !font || !numeric_ready(font)) return 0.0f;
+    if (min_digits > 16) min_digits = 16;
 
-    free(temp);
+    uint8_t slots[16];
+    size_t n = 0;
+    do {
+        slots[15 - n++] = (uint8_t)(value & 0xF);
+        value >>= 4;
+    } while (value || (int)n < min_digits);
+
+    return draw_numeric(font, slots + 16 - n, n, x, y, font->hex_width,
+                        ocfx_atlas_pack_color(color));
+}
+
+float ocfx_font_get_digit_width(ocfx_font_t *font) {
+    if (!font || !numeric_ready(font)) return 0.0f;
+    return font->digit_width;
 }
 
-/* Advanced text rendering - stubs for now */
+/* ============================================================================
+ * Wrapped layout
+ * ============================================================================ */
+
+/* Word of a paragraph: its bytes plus the spaces after it, measured once
+ * so re-wrapping at a new width needs no decoding or glyph lookups */
+typedef struct {
+    uint32_t start;               /* Byte offset in the paragraph */
+    uint32_t len;                 /* Word bytes (without the spaces) */
+    float width;
+    float space;                  /* Width of the following spaces */
+} layout_word_t;
+
+/* Wrapped line, as a byte range of its paragraph (trailing spaces cut) */
+typedef struct {
+    uint32_t start, end;
+    float width;
+} layout_line_t;
+
+/* Paragraph (text between newlines). Its line breaks hold for every wrap
+ * width in [fit_lo, fit_hi), so most resizes leave it untouched. */
+typedef struct {
+    size_t start, end;            /* Byte range in the text */
+    layout_word_t *words;         /* NULL until first wrapped */
+    uint32_t word_count;
+    layout_line_t *lines;
+    uint32_t line_count;
+    uint32_t line_capacity;
+    float fit_lo, fit_hi;
+    float break_width;            /* Width of the last break (exact breaks) */
+    bool broken;
+    bool exact;                   /* Breaks only hold at break_width */
+} layout_para_t;
+
+struct ocfx_text_layout_t {
+    ocfx_font_t *font;
+    const char *text;             /* View, not owned */
+    size_t len;
+    float width;                  /* <= 0: no wrapping */
+    ocfx_wrap_mode_t mode;
+    layout_para_t *paras;
+    size_t para_count;
+};
+
+static inline bool is_wrap_space(char c) {
+    return c == ' ' || c == '\t';
+}
+
+/* Split a paragraph into measured words */
+static bool measure_words(ocfx_text_layout_t *layout, layout_para_t *para) {
+    const char *text = layout->text + para->start;
+    uint32_t len = (uint32_t)(para->end - para->start);
+    float space = codepoint_advance(layout->font, ' ');
+
+    /* Words never outnumber half the bytes plus one */
+    layout_word_t *words = malloc(((size_t)len / 2 + 1) * sizeof(layout_word_t));
+    if (!words) return false;
+
+    uint32_t count = 0;
+    uint32_t i = 0;
+    do {
+        layout_word_t *word = &words[count++];
+        word->start = i;
+        while (i < len && !is_wrap_space(text[i])) i++;
+        word->len = i - word->start;
+        word->width = measure_span(layout->font, text + word->start, text + i);
+        uint32_t spaces = i;
+        while (i < len && is_wrap_space(text[i])) i++;
+        word->space = (float)(i - spaces) * space;
+    } while (i < len);
+
+    para->words = words;
+    para->word_count = count;
+    return true;
+}
+
+static bool push_line(layout_para_t *para, uint32_t start, uint32_t end, float width) {
+    if (para->line_count == para->line_capacity) {
+        uint32_t cap = para->line_capacity ? para->line_capacity * 2 : 4;
+        layout_line_t *lines = realloc(para->lines, cap * sizeof(layout_line_t));
+        if (!lines) return false;
+        para->lines = lines;
+        para->line_capacity = cap;
+    }
+    para->lines[para->line_count++] = (layout_line_t){start, end, width};
+    return true;
+}
+
+/* Break a word wider than the line at codepoint boundaries. Every piece
+ * but the last becomes a line; the last is returned as the open line. */
+static bool split_word(ocfx_text_layout_t *layout, layout_para_t *para,
+                       const layout_word_t *word, float width,
+                       uint32_t *open_start, float *open_width) {
+    const char *base = layout->text + para->start;
+    const char *p = base + word->start;
+    const char *end = p + word->len;
+    uint32_t piece_start = word->start;
+    float piece_width = 0;
+
+    while (p < end) {
+        const char *next = p;
+        uint32_t codepoint;
+        float advance = 0;
+        if (ocfx_utf8_decode(&next, end, &codepoint, 1) == 1) {
+            advance = codepoint_advance(layout->font, codepoint);
+        } else {
+            next = p + 1;         /* NUL or malformed byte: no glyph */
+        }
+
+        uint32_t offset = (uint32_t)(p - base);
+        if (piece_width > 0 && piece_width + advance > width) {
+            if (!push_line(para, piece_start, offset, piece_width)) return false;
+            piece_start = offset;
+            piece_width = 0;
+        }
+        piece_width += advance;
+        p = next;
+    }
+
+    *open_start = piece_start;
+    *open_width = piece_width;
+    return true;
+}
+
+/* First-fit breaking */
+static bool break_greedy(ocfx_text_layout_t *layout, layout_para_t *para, float width) {
+    float lo = 0;
+    float hi = INFINITY;
+    uint32_t line_start = 0, line_end = 0;
+    float line_width = 0;
+    float pending_space = 0;
+    bool open = false;
+
+    for (uint32_t k = 0; k < para->word_count; k++) {
+        const layout_word_t *word = &para->words[k];
+        uint32_t word_end = word->start + word->len;
+
+        if (open && line_width + pending_space + word->width > width) {
+            /* The line would take this word from fit_hi on */
+            if (line_width + pending_space + word->width < hi) {
+                hi = line_width + pending_space + word->width;
+            }
+            if (!push_line(para, line_start, line_end, line_width)) return false;
+            if (line_width > lo) lo = line_width;
+            open = false;
+        }
+
+        if (!open) {
+            if (word->width > width) {
+                if (!split_word(layout, para, word, width, &line_start, &line_width)) {
+                    return false;
+                }
+                para->exact = true;
+            } else {
+                line_start = word->start;
+                line_width = word->width;
+            }
+            open = true;
+        } else {
+            line_width += pending_space + word->width;
+        }
+        line_end = word_end;
+        pending_space = word->space;
+    }
+
+    if (!push_line(para, line_start, line_end, line_width)) return false;
+    if (line_width > lo) lo = line_width;
+    para->fit_lo = lo;
+    para->fit_hi = hi;
+    return true;
+}
+
+/* Minimum raggedness: minimize the summed squared slack of every line
+ * but the last. Falls back to first-fit when a word must be split. */
+static bool break_balanced(ocfx_text_layout_t *layout, layout_para_t *para, float width) {
+    uint32_t n = para->word_count;
+    const layout_word_t *words = para->words;
+
+    float total = 0;
+    for (uint32_t k = 0; k < n; k++) {
+        if (words[k].width > width) return break_greedy(layout, para, width);
+        total += words[k].width + (k + 1 < n ? words[k].space : 0);
+    }
+    if (total <= width) {
+        /* One line, for any width from its own on */
+        para->fit_lo = total;
+        para->fit_hi = INFINITY;
+        return push_line(para, 0, words[n - 1].start + words[n - 1].len, total);
+    }
+
+    /* prefix[k]: width of words [0, k) with their spaces */
+    double *prefix = malloc(((size_t)n + 1) * sizeof(double));
+    double *cost = malloc(((size_t)n + 1) * sizeof(double));
+    uint32_t *next = malloc((size_t)n * sizeof(uint32_t));
+    if (!prefix || !cost || !next) {
+        free(prefix);
+        free(cost);
+        free(next);
+        return false;
+    }
+    prefix[0] = 0;
+    for (uint32_t k = 0; k < n; k++) prefix[k + 1] = prefix[k] + words[k].width + words[k].space;
+
+    cost[n] = 0;
+    for (uint32_t i = n; i-- > 0;) {
+        cost[i] = INFINITY;
+        next[i] = i + 1;
+        for (uint32_t j = i; j < n; j++) {
+            double line = prefix[j + 1] - prefix[i] - words[j].space;
+            if (line > width && j > i) break;
+            double slack = width - line;
+            double c = (j + 1 == n ? 0 : slack * slack) + cost[j + 1];
+            if (c < cost[i]) {
+                cost[i] = c;
+                next[i] = j + 1;
+            }
+        }
+    }
+
+    bool ok = true;
+    for (uint32_t i = 0; ok && i < n; i = next[i]) {
+        uint32_t j = next[i] - 1;
+        float line = (float)(prefix[j + 1] - prefix[i] - words[j].space);
+        ok = push_line(para, words[i].start, words[j].start + words[j].len, line);
+    }
+    free(prefix);
+    free(cost);
+    free(next);
+
+    para->exact = true;
+    return ok;
+}
+
+/* Bring a paragraph's lines up to date with the layout width */
+static void wrap_para(ocfx_text_layout_t *layout, layout_para_t *para) {
+    float width = layout->width > 0 ? layout->width : INFINITY;
+    if (para->broken &&
+        (para->exact ? width == para->break_width
+                     : width >= para->fit_lo && (width < para->fit_hi || isinf(para->fit_hi)))) {
+        return;
+    }
+
+    para->line_count = 0;
+    para->exact = false;
+    para->break_width = width;
+    para->broken = true;
+
+    bool ok = para->words || measure_words(layout, para);
+    if (ok) {
+        ok = layout->mode == OCFX_WRAP_BALANCED ? break_balanced(layout, para, width)
+                                                : break_greedy(layout, para, width);
+    }
+    if (!ok) {
+        /* Out of memory: show the paragraph unwrapped, retry next time */
+        para->line_count = 0;
+        para->broken = false;
+        push_line(para, 0, (uint32_t)(para->end - para->start), 0);
+    }
+}
+
+/* Split text into paragraphs (lines are laid out lazily) */
+static bool layout_reset(ocfx_text_layout_t *layout, const char *text, size_t len) {
+    size_t count = 1;
+    for (const char *p = text; (p = memchr(p, '\n', (size_t)(text + len - p))); p++) count++;
+
+    layout_para_t *paras = calloc(count, sizeof(layout_para_t));
+    if (!paras) return false;
+
+    size_t start = 0;
+    for (size_t i = 0; i < count; i++) {
+        const char *nl = memchr(text + start, '\n', len - start);
+        size_t end = nl ? (size_t)(nl - text) : len;
+        paras[i].start = start;
+        paras[i].end = (end > start && text[end - 1] == '\r') ? end - 1 : end;
+        start = end + 1;
+    }
+
+    layout->text = text;
+    layout->len = len;
+    layout->paras = paras;
+    layout->para_count = count;
+    return true;
+}
+
+static void layout_free_paras(ocfx_text_layout_t *layout) {
+    for (size_t i = 0; i < layout->para_count; i++) {
+        free(layout->paras[i].words);
+        free(layout->paras[i].lines);
+    }
+    free(layout->paras);
+    layout->paras = NULL;
+    layout->para_count = 0;
+}
+
+/* Draw the lines intersecting [visible.y, visible.y + height) */
+static void draw_layout(ocfx_text_layout_t *layout, float x, float y, float line_spacing,
+                        ocfx_rect_t visible, ocfx_color_t color) {
+    ocfx_font_t *font = layout->font;
+    float line_height = (float)font->height * (line_spacing > 0 ? line_spacing : 1.0f);
+    float bottom = visible.y + visible.height;
+
+    for (size_t i = 0; i < layout->para_count && y < bottom; i++) {
+        layout_para_t *para = &layout->paras[i];
+        wrap_para(layout, para);
+
+        /* Whole paragraph above the visible area */
+        if (y + para->line_count * line_height <= visible.y) {
+            y += para->line_count * line_height;
+            continue;
+        }
+
+        const char *base = layout->text + para->start;
+        for (uint32_t l = 0; l < para->line_count && y < bottom; l++) {
+            const layout_line_t *line = &para->lines[l];
+            if (y + line_height > visible.y && line->end > line->start) {
+                draw_text(font, base + line->start, line->end - line->start, x, y, NULL, color);
+            }
+            y += line_height;
+        }
+    }
+}
+
+ocfx_text_layout_t* ocfx_text_layout_create(ocfx_font_t *font, const char *text, size_t len) {
+    if (!font || !text) return NULL;
+
+    ocfx_text_layout_t *layout = calloc(1, sizeof(ocfx_text_layout_t));
+    if (!layout) return NULL;
+    layout->font = font;
+
+    if (!layout_reset(layout, text, len)) {
+        free(layout);
+        return NULL;
+    }
+    return layout;
+}
+
+void ocfx_text_layout_destroy(ocfx_text_layout_t *layout) {
+    if (!layout) return;
+    layout_free_paras(layout);
+    free(layout);
+}
+
+void ocfx_text_layout_set_width(ocfx_text_layout_t *layout, float width) {
+    if (layout) layout->width = width;
+}
+
+void ocfx_text_layout_set_mode(ocfx_text_layout_t *layout, ocfx_wrap_mode_t mode) {
+    if (!layout || layout->mode == mode) return;
+    layout->mode = mode;
+    for (size_t i = 0; i < layout->para_count; i++) layout->paras[i].broken = false;
+}
+
+size_t ocfx_text_layout_line_count(ocfx_text_layout_t *layout) {
+    if (!layout) return 0;
+
+    size_t count = 0;
+    for (size_t i = 0; i < layout->para_count; i++) {
+        wrap_para(layout, &layout->paras[i]);
+        count += layout->paras[i].line_count;
+    }
+    return count;
+}
+
+void ocfx_text_layout_draw(ocfx_renderer_t *renderer, ocfx_text_layout_t *layout,
+                           float x, float y, float line_spacing, ocfx_rect_t visible,
+                           ocfx_color_t color) {
+    if (!renderer || !layout) return;
+    draw_layout(layout, x, y, line_spacing, visible, color);
+}
+
+/* Layout kept per font for ocfx_text_draw_wrapped, found again by string
+ * hash; the caller's pointer is adopted on every hit */
+static ocfx_text_layout_t* cached_layout(ocfx_font_t *font, const char *text, size_t len) {
+    uint64_t hash = ocfx_strike_hash((const uint8_t *)text, len);
+    uint64_t frame = ocfx_render_get_frame(font->renderer);
+
+    wrap_cache_entry_t *victim = &font->wrap_cache[0];
+    for (int i = 0; i < OCFX_WRAP_CACHE_SIZE; i++) {
+        wrap_cache_entry_t *entry = &font->wrap_cache[i];
+        if (entry->layout && entry->hash == hash && entry->layout->len == len &&
+            memcmp(entry->text, text, len) == 0) {
+            entry->last_used = frame;
+            entry->layout->text = text;
+            return entry->layout;
+        }
+        if (victim->layout && (!entry->layout || entry->last_used < victim->last_used)) {
+            victim = entry;
+        }
+    }
+
+    char *copy = malloc(len ? len : 1);
+    ocfx_text_layout_t *layout = copy ? ocfx_text_layout_create(font, text, len) : NULL;
+    if (!layout) {
+        free(copy);
+        return NULL;
+    }
+    memcpy(copy, text, len);
+
+    ocfx_text_layout_destroy(victim->layout);
+    free(victim->text);
+    *victim = (wrap_cache_entry_t){hash, frame, copy, layout};
+    return layout;
+}
+
+/* Advanced text rendering */
 void ocfx_text_draw_aligned(ocfx_renderer_t *renderer, ocfx_font_t *font,
                             const char *text, ocfx_rect_t rect,
                             ocfx_text_align_t align, ocfx_text_baseline_t baseline,
                             ocfx_color_t color) {
-    (void)rect;
-    (void)align;
-    (void)baseline;
-    /* TODO: Implement alignment */
-    ocfx_text_draw(renderer, font, text, rect.x, rect.y, color);
+    if (!renderer || !font || !text) return;
+
+    /* Vertical placement needs only the font metrics (descent is negative) */
+    float box = (float)(font->ascent - font->descent);
+    float y = rect.y;
+    switch (baseline) {
+    case OCFX_TEXT_BASELINE_TOP: break;
+    case OCFX_TEXT_BASELINE_MIDDLE: y += (rect.height - box) * 0.5f; break;
+    case OCFX_TEXT_BASELINE_BOTTOM: y += rect.height - box; break;
+    case OCFX_TEXT_BASELINE_ALPHABETIC: y -= (float)font->ascent; break;
+    }
+
+    /* Keep bitmap glyphs on whole pixels, whichever way they are aligned */
+    bool snap = font->mode == OCFX_ATLAS_MODE_BITMAP;
+    if (snap) y = floorf(y + 0.5f);
+
+    size_t len = strlen(text);
+    if (align == OCFX_TEXT_ALIGN_LEFT) {
+        draw_plain(font, text, len, snap ? floorf(rect.x + 0.5f) : rect.x, y, color);
+        return;
+    }
+
+    /* Lay out once into a run (cached, or the font's scratch run), which
+     * yields the width and the quads together; the quads are then copied
+     * to the batch already shifted into place */
+    ocfx_text_run_t *run = font->run_cache ? cached_run(font, text, len) : NULL;
+    if (!run) {
+        if (!font->scratch) {
+            font->scratch = calloc(1, sizeof(ocfx_text_run_t));
+            if (!font->scratch) return;
+            font->scratch->font = font;
+        }
+        run = font->scratch;
+        if (!run_set_text(run, text, len)) return;
+    }
+
+    float x = rect.x + (rect.width - run->width) *
+                       (align == OCFX_TEXT_ALIGN_CENTER ? 0.5f : 1.0f);
+    if (snap) x = floorf(x + 0.5f);
+    draw_run(run, x, y, ocfx_atlas_pack_color(color));
 }
 
 void ocfx_text_draw_wrapped(ocfx_renderer_t *renderer, ocfx_font_t *font,
                             const char *text, ocfx_rect_t rect, float line_spacing,
                             ocfx_color_t color) {
-    (void)rect;
-    (void)line_spacing;
-    /* TODO: Implement word wrapping */
-    ocfx_text_draw(renderer, font, text, rect.x, rect.y, color);
+    if (!renderer || !font || !text) return;
+
+    ocfx_text_layout_t *layout = cached_layout(font, text, strlen(text));
+    if (!layout) return;
+    layout->width = rect.width;
+    draw_layout(layout, rect.x, rect.y, line_spacing, rect, color);
 }
 
 /* UTF-8 support */
 bool ocfx_text_is_valid_utf8(const char *text, size_t len) {
     if (!text) return false;
+    return ocfx_utf8_validate(text, len);
+}
+
+size_t ocfx_text_utf8_char_count(const char *text) {
+    if (!text) return 0;
+    return ocfx_utf8_count(text, strlen(text));
+}
+
+size_t ocfx_text_utf8_decode(const char *text, size_t len, uint32_t *codepoints, size_t max,
+                             size_t *consumed) {
+    if (!text || !codepoints) {
+        if (consumed) *consumed = 0;
+        return 0;
+    }
 
     const char *p = text;
-    const char *end = text + len;
+    size_t n = ocfx_utf8_decode(&p, text + len, codepoints, max);
+    if (consumed) *consumed = (size_t)(p - text);
+    return n;
+}
 
-    while (p < end && *p) {
-        const unsigned char *s = (const unsigned char *)p;
+/* ============================================================================
+ * Internal API (see font.h)
+ * ============================================================================ */
 
-        /* 1-byte sequence */
-        if ((*s & 0x80) == 0) {
-            p++;
-        }
-        /* 2-byte sequence */
-        else if ((*s & 0xE0) == 0xC0) {
-            if (p + 1 >= end || (s[1] & 0xC0) != 0x80) return false;
-            p += 2;
-        }
-        /* 3-byte sequence */
-        else if ((*s & 0xF0) == 0xE0) {
-            if (p + 2 >= end || (s[1] & 0xC0) != 0x80 || (s[2] & 0xC0) != 0x80) return false;
-            p += 3;
-        }
-        /* 4-byte sequence */
-        else if ((*s & 0xF8) == 0xF0) {
-            if (p + 3 >= end || (s[1] & 0xC0) != 0x80 || (s[2] & 0xC0) != 0x80 || (s[3] & 0xC0) != 0x80) return false;
-            p += 4;
-        }
-        /* Invalid */
-        else {
-            return false;
-        }
-    }
+ocfx_atlas_t* ocfx_font_get_atlas(ocfx_font_t *font) {
+    return font->atlas;
+}
 
-    return true;
+void ocfx_font_prepare_glyphs(ocfx_font_t *font, const uint32_t *codepoints, size_t count) {
+    prepare_codepoints(font, codepoints, count);
 }
 
-size_t ocfx_text_utf8_char_count(const char *text) {
-    if (!text) return 0;
+ocfx_glyph_t* ocfx_font_lookup_glyph(ocfx_font_t *font, uint32_t codepoint,
+                                     bool *placeholder) {
+    ocfx_glyph_t *glyph = get_glyph(font, codepoint);
+    *placeholder = glyph && is_placeholder(font, glyph);
+    return glyph;
+}
 
-    size_t count = 0;
+float ocfx_font_codepoint_advance(ocfx_font_t *font, uint32_t codepoint) {
+    return codepoint_advance(font, codepoint);
+}
+
+size_t ocfx_font_fit_n(ocfx_font_t *font, const char *text, size_t len, float max_width) {
     const char *p = text;
+    const char *end = text + len;
+    uint32_t codepoints[OCFX_DECODE_CHUNK];
+    float pen = 0.0f;
+    size_t n;
+
+    for (;;) {
+        const char *chunk = p;
+        if ((n = decode_span(&p, end, codepoints)) == 0) break;
+
+        float w = 0.0f;
+        for (size_t i = 0; i < n; i++) w += codepoint_advance(font, codepoints[i]);
+        if (pen + w < max_width) {
+            pen += w;
+            continue;
+        }
 
-    while (*p) {
-        uint32_t codepoint = utf8_decode(&p);
-        if (codepoint == 0) break;
-        count++;
+        /* The edge falls inside this chunk: step through it */
+        p = chunk;
+        for (size_t i = 0; i < n && pen < max_width; i++) {
+            uint32_t codepoint;
+            while (p < end && *p == '\0') p++;
+            ocfx_utf8_decode(&p, end, &codepoint, 1);
+            pen += codepoint_advance(font, codepoints[i]);
+        }
+        break;
     }
-
-    return count;
+    return (size_t)(p - text);
 }
@@ -0,0 +1,518 @@
+/* OCFX - Editable Text Implementation
+ * The document is a piece table over the original text and an append-only
+ * buffer of inserted text. Line starts live in a gap buffer that follows
+ * the edited line: starts before the gap are absolute, starts after it
+ * are distances from the end of the document, so an edit changes neither
+ * and typing costs the same on line 1 as on line 100000. Per-line caches
+ * (a prepared run for drawing, prefix advances for carets and hit
+ * testing) are built on first use and dropped only for lines an edit
+ * touches, or when they scroll out of view.
+ */
+
+#include "ocfx/textedit.h"
+#include "font.h"
+#include "utf8.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/* Piece of the document: a slice of the original or the added text */
+typedef struct {
+    uint8_t source;               /* 0 = original, 1 = added */
+    size_t start;
+    size_t len;
+} piece_t;
+
+/* Cached layout of one line (all empty until first use) */
+typedef struct {
+    ocfx_text_run_t *run;
+    float *prefix;                /* Caret x before each codepoint, plus the end */
+    uint32_t *offsets;            /* Byte offset of each codepoint, plus the end */
+    uint32_t count;               /* Codepoints */
+    bool measured;
+} line_cache_t;
+
+/* Text buffer structure (opaque to users) */
+struct ocfx_text_buffer_t {
+    ocfx_font_t *font;
+    float line_spacing;
+
+    /* Piece table */
+    char *original;
+    char *added;
+    size_t added_len, added_capacity;
+    piece_t *pieces;
+    size_t piece_count, piece_capacity;
+    size_t length;
+
+    /* Line index: gap buffers of starts and caches, lines [0, gap) stored
+     * in front of the gap (see start_of) */
+    size_t *starts;
+    line_cache_t *lines;
+    size_t line_count, line_capacity;
+    size_t gap;
+    size_t cached_lo, cached_hi;  /* Lines outside [lo, hi) hold no cache */
+
+    /* Reused line text */
+    char *scratch;
+    size_t scratch_capacity;
+};
+
+/* ============================================================================
+ * Storage helpers
+ * ============================================================================ */
+
+static bool grow(void **ptr, size_t *capacity, size_t needed, size_t elem_size) {
+    if (needed <= *capacity) return true;
+    size_t cap = *capacity ? *capacity : 16;
+    while (cap < needed) cap *= 2;
+    void *p = realloc(*ptr, cap * elem_size);
+    if (!p) return false;
+    *ptr = p;
+    *capacity = cap;
+    return true;
+}
+
+static inline const char* piece_text(const ocfx_text_buffer_t *buffer, const piece_t *piece) {
+    return (piece->source ? buffer->added : buffer->original) + piece->start;
+}
+
+/* Index of the piece starting at offset, splitting one if needed
+ * (SIZE_MAX if out of memory) */
+static size_t split_at(ocfx_text_buffer_t *buffer, size_t offset) {
+    size_t pos = 0;
+    for (size_t i = 0; i < buffer->piece_count; i++) {
+        piece_t *piece = &buffer->pieces[i];
+        if (pos == offset) return i;
+        if (offset < pos + piece->len) {
+            if (!grow((void **)&buffer->pieces, &buffer->piece_capacity,
+                      buffer->piece_count + 1, sizeof(piece_t))) {
+                return SIZE_MAX;
+            }
+            piece = &buffer->pieces[i];
+            memmove(piece + 2, piece + 1, (buffer->piece_count - i - 1) * sizeof(piece_t));
+            size_t head = offset - pos;
+            piece[1] = (piece_t){piece->source, piece->start + head, piece->len - head};
+            piece->len = head;
+            buffer->piece_count++;
+            return i + 1;
+        }
+        pos += piece->len;
+    }
+    return buffer->piece_count;
+}
+
+/* ============================================================================
+ * Line index and caches
+ * ============================================================================ */
+
+/* Array slot of a line */
+static inline size_t line_slot(const ocfx_text_buffer_t *buffer, size_t line) {
+    return line < buffer->gap ? line : line + buffer->line_capacity - buffer->line_count;
+}
+
+static inline size_t start_of(const ocfx_text_buffer_t *buffer, size_t line) {
+    if (line < buffer->gap) return buffer->starts[line];
+    return buffer->length - buffer->starts[line_slot(buffer, line)];
+}
+
+static inline line_cache_t* cache_of(ocfx_text_buffer_t *buffer, size_t line) {
+    return &buffer->lines[line_slot(buffer, line)];
+}
+
+/* Move the gap in front of line gap, converting the starts that cross it
+ * (call before the length changes) */
+static void move_gap(ocfx_text_buffer_t *buffer, size_t gap) {
+    size_t gap_len = buffer->line_capacity - buffer->line_count;
+    while (buffer->gap > gap) {
+        buffer->gap--;
+        buffer->starts[buffer->gap + gap_len] = buffer->length - buffer->starts[buffer->gap];
+        buffer->lines[buffer->gap + gap_len] = buffer->lines[buffer->gap];
+    }
+    while (buffer->gap < gap) {
+        buffer->starts[buffer->gap] = buffer->length - buffer->starts[buffer->gap + gap_len];
+        buffer->lines[buffer->gap] = buffer->lines[buffer->gap + gap_len];
+        buffer->gap++;
+    }
+}
+
+static size_t line_of(const ocfx_text_buffer_t *buffer, size_t offset) {
+    size_t lo = 0, hi = buffer->line_count;
+    while (hi - lo > 1) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (start_of(buffer, mid) <= offset) lo = mid;
+        else hi = mid;
+    }
+    return lo;
+}
+
+/* Bytes of a line, without its '\n' */
+static size_t line_length(const ocfx_text_buffer_t *buffer, size_t line) {
+    size_t end = line + 1 < buffer->line_count ? start_of(buffer, line + 1) - 1 : buffer->length;
+    return end - start_of(buffer, line);
+}
+
+static void free_cache(line_cache_t *cache) {
+    ocfx_text_run_destroy(cache->run);
+    free(cache->prefix);
+    free(cache->offsets);
+    memset(cache, 0, sizeof(*cache));
+}
+
+static void note_cached(ocfx_text_buffer_t *buffer, size_t line) {
+    if (buffer->cached_lo >= buffer->cached_hi) {
+        buffer->cached_lo = line;
+        buffer->cached_hi = line + 1;
+        return;
+    }
+    if (line < buffer->cached_lo) buffer->cached_lo = line;
+    if (line >= buffer->cached_hi) buffer->cached_hi = line + 1;
+}
+
+/* Copy a line into the scratch buffer */
+static const char* line_text(ocfx_text_buffer_t *buffer, size_t line, size_t *len) {
+    *len = line_length(buffer, line);
+    if (!grow((void **)&buffer->scratch, &buffer->scratch_capacity, *len + 1, 1)) return NULL;
+    ocfx_text_buffer_read(buffer, start_of(buffer, line), *len, buffer->scratch);
+    return buffer->scratch;
+}
+
+static bool ensure_metrics(ocfx_text_buffer_t *buffer, size_t line) {
+    line_cache_t *cache = cache_of(buffer, line);
+    if (cache->measured) return true;
+
+    size_t len;
+    const char *text = line_text(buffer, line, &len);
+    if (!text) return false;
+
+    /* Codepoints never outnumber bytes */
+    cache->prefix = malloc((len + 1) * sizeof(float));
+    cache->offsets = malloc((len + 1) * sizeof(uint32_t));
+    if (!cache->prefix || !cache->offsets) {
+        free_cache(cache);
+        return false;
+    }
+
+    const char *p = text;
+    const char *end = text + len;
+    float pen = 0.0f;
+    uint32_t count = 0;
+    while (p < end) {
+        uint32_t codepoint;
+        cache->prefix[count] = pen;
+        cache->offsets[count] = (uint32_t)(p - text);
+        if (ocfx_utf8_decode(&p, end, &codepoint, 1) == 0) {
+            p++;  /* NUL or malformed byte: a caret stop without width */
+        } else {
+            pen += ocfx_font_codepoint_advance(buffer->font, codepoint);
+        }
+        count++;
+    }
+    cache->prefix[count] = pen;
+    cache->offsets[count] = (uint32_t)len;
+    cache->count = count;
+    cache->measured = true;
+    note_cached(buffer, line);
+    return true;
+}
+
+static ocfx_text_run_t* ensure_run(ocfx_text_buffer_t *buffer, size_t line) {
+    line_cache_t *cache = cache_of(buffer, line);
+    if (cache->run) return cache->run;
+
+    size_t len;
+    const char *text = line_text(buffer, line, &len);
+    if (!text) return NULL;
+    cache->run = ocfx_text_run_create(buffer->font, text, len);
+    if (cache->run) note_cached(buffer, line);
+    return cache->run;
+}
+
+static inline float line_height(const ocfx_text_buffer_t *buffer) {
+    return (float)ocfx_font_get_height(buffer->font) * buffer->line_spacing;
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+ocfx_text_buffer_t* ocfx_text_buffer_create(ocfx_font_t *font, const char *text, size_t len) {
+    if (!font || (!text && len > 0)) return NULL;
+
+    ocfx_text_buffer_t *buffer = calloc(1, sizeof(ocfx_text_buffer_t));
+    if (!buffer) return NULL;
+    buffer->font = font;
+    buffer->line_spacing = 1.0f;
+
+    /* The original text is copied once and never changes */
+    buffer->original = malloc(len ? len : 1);
+    if (!buffer->original) goto fail;
+    if (len) memcpy(buffer->original, text, len);
+    buffer->length = len;
+    if (len) {
+        if (!grow((void **)&buffer->pieces, &buffer->piece_capacity, 1, sizeof(piece_t))) {
+            goto fail;
+        }
+        buffer->pieces[0] = (piece_t){0, 0, len};
+        buffer->piece_count = 1;
+    }
+
+    size_t lines = 1;
+    for (const char *p = text; p && (p = memchr(p, '\n', (size_t)(text + len - p))); p++) {
+        lines++;
+    }
+    if (!grow((void **)&buffer->starts, &buffer->line_capacity, lines, sizeof(size_t))) goto fail;
+    buffer->lines = calloc(buffer->line_capacity, sizeof(line_cache_t));
+    if (!buffer->lines) goto fail;
+
+    buffer->starts[buffer->line_count++] = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (text[i] == '\n') buffer->starts[buffer->line_count++] = i + 1;
+    }
+    buffer->gap = buffer->line_count;
+    return buffer;
+
+fail:
+    ocfx_text_buffer_destroy(buffer);
+    return NULL;
+}
+
+void ocfx_text_buffer_destroy(ocfx_text_buffer_t *buffer) {
+    if (!buffer) return;
+
+    if (buffer->lines) {
+        for (size_t i = buffer->cached_lo; i < buffer->cached_hi; i++) {
+            free_cache(cache_of(buffer, i));
+        }
+    }
+    free(buffer->lines);
+    free(buffer->starts);
+    free(buffer->pieces);
+    free(buffer->added);
+    free(buffer->original);
+    free(buffer->scratch);
+    free(buffer);
+}
+
+/* Widen the gap to hold needed lines; the part after it moves to the end */
+static bool reserve_lines(ocfx_text_buffer_t *buffer, size_t needed) {
+    if (needed <= buffer->line_capacity) return true;
+
+    size_t old_capacity = buffer->line_capacity;
+    size_t capacity = old_capacity;
+    if (!grow((void **)&buffer->starts, &capacity, needed, sizeof(size_t))) return false;
+    line_cache_t *lines = realloc(buffer->lines, capacity * sizeof(line_cache_t));
+    if (!lines) {
+        /* starts may have grown; line_capacity still bounds both arrays */
+        return false;
+    }
+    buffer->lines = lines;
+    buffer->line_capacity = capacity;
+
+    size_t tail = buffer->line_count - buffer->gap;
+    memmove(buffer->starts + capacity - tail, buffer->starts + old_capacity - tail,
+            tail * sizeof(size_t));
+    memmove(buffer->lines + capacity - tail, buffer->lines + old_capacity - tail,
+            tail * sizeof(line_cache_t));
+    return true;
+}
+
+bool ocfx_text_buffer_insert(ocfx_text_buffer_t *buffer, size_t offset,
+                             const char *text, size_t len) {
+    if (!buffer || !text || offset > buffer->length) return false;
+    if (len == 0) return true;
+
+    size_t breaks = 0;
+    for (size_t i = 0; i < len; i++) breaks += text[i] == '\n';
+
+    /* Reserve everything first so a failure leaves the buffer untouched */
+    if (!reserve_lines(buffer, buffer->line_count + breaks) ||
+        !grow((void **)&buffer->added, &buffer->added_capacity, buffer->added_len + len, 1) ||
+        !grow((void **)&buffer->pieces, &buffer->piece_capacity,
+              buffer->piece_count + 2, sizeof(piece_t))) {
+        return false;
+    }
+
+    size_t index = split_at(buffer, offset);
+    size_t added_start = buffer->added_len;
+    memcpy(buffer->added + added_start, text, len);
+    buffer->added_len += len;
+
+    /* Typing extends the piece that the previous keystroke added */
+    piece_t *prev = index > 0 ? &buffer->pieces[index - 1] : NULL;
+    if (prev && prev->source == 1 && prev->start + prev->len == added_start) {
+        prev->len += len;
+    } else {
+        memmove(&buffer->pieces[index + 1], &buffer->pieces[index],
+                (buffer->piece_count - index) * sizeof(piece_t));
+        buffer->pieces[index] = (piece_t){1, added_start, len};
+        buffer->piece_count++;
+    }
+
+    /* With the gap after the edited line, no stored start changes; new
+     * lines go into the gap */
+    size_t line = line_of(buffer, offset);
+    move_gap(buffer, line + 1);
+    buffer->length += len;
+    if (breaks) {
+        for (size_t i = 0; i < len; i++) {
+            if (text[i] != '\n') continue;
+            buffer->starts[buffer->gap] = offset + i + 1;
+            memset(&buffer->lines[buffer->gap], 0, sizeof(line_cache_t));
+            buffer->gap++;
+        }
+        buffer->line_count += breaks;
+        if (buffer->cached_lo > line) buffer->cached_lo += breaks;
+        if (buffer->cached_hi > line + 1) buffer->cached_hi += breaks;
+    }
+    free_cache(cache_of(buffer, line));
+    return true;
+}
+
+bool ocfx_text_buffer_delete(ocfx_text_buffer_t *buffer, size_t offset, size_t len) {
+    if (!buffer || offset > buffer->length) return false;
+    if (len > buffer->length - offset) len = buffer->length - offset;
+    if (len == 0) return true;
+
+    size_t first = split_at(buffer, offset);
+    if (first == SIZE_MAX) return false;
+    size_t last = split_at(buffer, offset + len);
+    if (last == SIZE_MAX) return false;
+    memmove(&buffer->pieces[first], &buffer->pieces[last],
+            (buffer->piece_count - last) * sizeof(piece_t));
+    buffer->piece_count -= last - first;
+
+    /* Lines starting inside the deleted range merge into the first one */
+    size_t line = line_of(buffer, offset);
+    size_t merged = line_of(buffer, offset + len) - line;
+    move_gap(buffer, line + 1);
+    if (merged) {
+        /* The merged lines are the first ones after the gap */
+        for (size_t i = line + 1; i <= line + merged; i++) free_cache(cache_of(buffer, i));
+        buffer->line_count -= merged;
+        if (buffer->cached_lo > line + 1) {
+            buffer->cached_lo = buffer->cached_lo - merged > line + 1 ?
+                                buffer->cached_lo - merged : line + 1;
+        }
+        if (buffer->cached_hi > line + 1) {
+            buffer->cached_hi = buffer->cached_hi - merged > line + 1 ?
+                                buffer->cached_hi - merged : line + 1;
+        }
+    }
+    buffer->length -= len;
+
+    free_cache(cache_of(buffer, line));
+    return true;
+}
+
+size_t ocfx_text_buffer_length(ocfx_text_buffer_t *buffer) {
+    return buffer ? buffer->length : 0;
+}
+
+size_t ocfx_text_buffer_line_count(ocfx_text_buffer_t *buffer) {
+    return buffer ? buffer->line_count : 0;
+}
+
+size_t ocfx_text_buffer_line_start(ocfx_text_buffer_t *buffer, size_t line) {
+    if (!buffer) return 0;
+    if (line >= buffer->line_count) return buffer->length;
+    return start_of(buffer, line);
+}
+
+size_t ocfx_text_buffer_line_of(ocfx_text_buffer_t *buffer, size_t offset) {
+    return buffer ? line_of(buffer, offset) : 0;
+}
+
+size_t ocfx_text_buffer_read(ocfx_text_buffer_t *buffer, size_t offset, size_t len, char *out) {
+    if (!buffer || !out || offset >= buffer->length) return 0;
+    if (len > buffer->length - offset) len = buffer->length - offset;
+
+    size_t pos = 0, copied = 0;
+    for (size_t i = 0; i < buffer->piece_count && copied < len; i++) {
+        const piece_t *piece = &buffer->pieces[i];
+        size_t piece_end = pos + piece->len;
+        if (piece_end > offset + copied) {
+            size_t skip = offset + copied - pos;
+            size_t n = piece->len - skip;
+            if (n > len - copied) n = len - copied;
+            memcpy(out + copied, piece_text(buffer, piece) + skip, n);
+            copied += n;
+        }
+        pos = piece_end;
+    }
+    return copied;
+}
+
+void ocfx_text_buffer_set_line_spacing(ocfx_text_buffer_t *buffer, float line_spacing) {
+    if (buffer) buffer->line_spacing = line_spacing > 0.0f ? line_spacing : 1.0f;
+}
+
+void ocfx_text_buffer_caret(ocfx_text_buffer_t *buffer, size_t offset, float *x, float *y) {
+    if (x) *x = 0.0f;
+    if (y) *y = 0.0f;
+    if (!buffer) return;
+    if (offset > buffer->length) offset = buffer->length;
+
+    size_t line = line_of(buffer, offset);
+    if (y) *y = (float)line * line_height(buffer);
+    if (!x || !ensure_metrics(buffer, line)) return;
+
+    /* First codepoint at or after the offset */
+    const line_cache_t *cache = cache_of(buffer, line);
+    uint32_t target = (uint32_t)(offset - start_of(buffer, line));
+    uint32_t lo = 0, hi = cache->count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (cache->offsets[mid] < target) lo = mid + 1;
+        else hi = mid;
+    }
+    *x = cache->prefix[lo];
+}
+
+size_t ocfx_text_buffer_hit_test(ocfx_text_buffer_t *buffer, float x, float y) {
+    if (!buffer) return 0;
+
+    float row = y > 0.0f ? floorf(y / line_height(buffer)) : 0.0f;
+    size_t line = row < (float)buffer->line_count ? (size_t)row : buffer->line_count - 1;
+    size_t start = start_of(buffer, line);
+    if (!ensure_metrics(buffer, line)) return start;
+
+    /* First glyph whose midpoint lies right of x: the caret goes before it */
+    const line_cache_t *cache = cache_of(buffer, line);
+    uint32_t lo = 0, hi = cache->count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if ((cache->prefix[mid] + cache->prefix[mid + 1]) * 0.5f <= x) lo = mid + 1;
+        else hi = mid;
+    }
+    return start + cache->offsets[lo];
+}
+
+void ocfx_text_buffer_draw(ocfx_renderer_t *renderer, ocfx_text_buffer_t *buffer,
+                           float x, float y, ocfx_rect_t visible, ocfx_color_t color) {
+    if (!renderer || !buffer) return;
+
+    float lh = line_height(buffer);
+    if (lh <= 0.0f) return;
+
+    float top = floorf((visible.y - y) / lh);
+    float bottom = ceilf((visible.y + visible.height - y) / lh);
+    size_t first = top > 0.0f ? (size_t)top : 0;
+    size_t last = bottom > 0.0f ? (size_t)bottom : 0;
+    if (last > buffer->line_count) last = buffer->line_count;
+    if (first > last) first = last;
+
+    /* Caches of lines that scrolled away are released, so memory follows
+     * the view rather than the document */
+    for (size_t i = buffer->cached_lo; i < buffer->cached_hi; i++) {
+        if (i < first || i >= last) free_cache(cache_of(buffer, i));
+    }
+    buffer->cached_lo = first;
+    buffer->cached_hi = last;
+
+    for (size_t line = first; line < last; line++) {
+        ocfx_text_run_t *run = ensure_run(buffer, line);
+        if (run) ocfx_text_run_draw(renderer, run, x, y + (float)line * lh, color);
+    }
+}
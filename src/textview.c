@@ -0,0 +1,272 @@
+/* OCFX - Text View Implementation
+ * Line starts are recorded in fixed-size chunks by an indexing thread and
+ * published with a release store of the line count, so the render thread
+ * reads the index without locking while it grows. Drawing looks up only
+ * the visible lines and cuts each at the right edge of the view.
+ */
+
+#define _POSIX_C_SOURCE 200809L  /* For pthreads and mmap */
+
+#include "ocfx/textview.h"
+#include "font.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifndef OCFX_TEXT_VIEW_CHUNK
+#define OCFX_TEXT_VIEW_CHUNK 65536       /* Line starts per index chunk */
+#endif
+
+#ifndef OCFX_TEXT_VIEW_SYNC_BYTES
+#define OCFX_TEXT_VIEW_SYNC_BYTES (1u << 20)  /* Smaller buffers index at once */
+#endif
+
+#define OCFX_TEXT_VIEW_BLOCK (1u << 20)  /* Bytes scanned between publishes */
+
+/* Text view structure (opaque to users) */
+struct ocfx_text_view_t {
+    ocfx_font_t *font;
+    const char *text;
+    size_t len;
+    bool mapped;                  /* text is our own mapping of a file */
+    size_t top;
+
+    /* Line starts, OCFX_TEXT_VIEW_CHUNK per chunk. The chunk table is
+     * sized for the worst case up front, so it never moves under readers. */
+    uint64_t **chunks;
+    size_t chunk_slots;
+    atomic_size_t indexed;        /* Line starts published so far */
+    atomic_bool complete;
+    atomic_bool stop;
+
+    pthread_t thread;
+    bool threaded;
+};
+
+/* ============================================================================
+ * Line index
+ * ============================================================================ */
+
+static inline uint64_t line_start(const ocfx_text_view_t *view, size_t line) {
+    return view->chunks[line / OCFX_TEXT_VIEW_CHUNK][line % OCFX_TEXT_VIEW_CHUNK];
+}
+
+static bool append_line(ocfx_text_view_t *view, size_t count, uint64_t offset) {
+    uint64_t **chunk = &view->chunks[count / OCFX_TEXT_VIEW_CHUNK];
+    if (!*chunk) {
+        *chunk = malloc(OCFX_TEXT_VIEW_CHUNK * sizeof(uint64_t));
+        if (!*chunk) return false;
+    }
+    (*chunk)[count % OCFX_TEXT_VIEW_CHUNK] = offset;
+    return true;
+}
+
+/* Scan the buffer for line breaks, publishing progress every block */
+static void index_lines(ocfx_text_view_t *view) {
+    const char *text = view->text;
+    const char *end = text + view->len;
+    const char *p = text;
+    size_t count = 0;
+
+    if (view->len > 0 && append_line(view, count, 0)) count++;
+    else p = end;
+
+    while (p < end && !atomic_load_explicit(&view->stop, memory_order_relaxed)) {
+        const char *block_end = (size_t)(end - p) > OCFX_TEXT_VIEW_BLOCK ?
+                                p + OCFX_TEXT_VIEW_BLOCK : end;
+        const char *nl;
+        while ((nl = memchr(p, '\n', (size_t)(block_end - p))) != NULL) {
+            p = nl + 1;
+            if (p == end) break;  /* A trailing break starts no line */
+            if (!append_line(view, count, (uint64_t)(p - text))) {
+                fprintf(stderr, "OCFX: Out of memory indexing text view\n");
+                p = end;
+                break;
+            }
+            count++;
+        }
+        if (p < block_end) p = block_end;
+        atomic_store_explicit(&view->indexed, count, memory_order_release);
+    }
+
+    atomic_store_explicit(&view->indexed, count, memory_order_release);
+    atomic_store_explicit(&view->complete, true, memory_order_release);
+}
+
+static void* index_main(void *arg) {
+    index_lines(arg);
+    return NULL;
+}
+
+/* Snapshot of the indexer's progress. complete is loaded first: once it
+ * reads true, indexed is final, so the pair is never stale-count-plus-done. */
+static size_t index_state(ocfx_text_view_t *view, bool *complete) {
+    *complete = atomic_load_explicit(&view->complete, memory_order_acquire);
+    return atomic_load_explicit(&view->indexed, memory_order_acquire);
+}
+
+/* Lines whose extent is known: all of them once complete, otherwise all
+ * but the last started one (complete may be NULL) */
+static size_t known_lines(ocfx_text_view_t *view, bool *complete) {
+    bool done;
+    size_t indexed = index_state(view, &done);
+    if (complete) *complete = done;
+    if (done || indexed == 0) return indexed;
+    return indexed - 1;
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+static ocfx_text_view_t* create_view(ocfx_font_t *font, const char *text, size_t len,
+                                     bool mapped) {
+    ocfx_text_view_t *view = calloc(1, sizeof(ocfx_text_view_t));
+    if (!view) return NULL;
+
+    view->font = font;
+    view->text = text;
+    view->len = len;
+    view->mapped = mapped;
+    view->chunk_slots = len / OCFX_TEXT_VIEW_CHUNK + 1;
+    view->chunks = calloc(view->chunk_slots, sizeof(uint64_t *));
+    if (!view->chunks) {
+        free(view);
+        return NULL;
+    }
+    atomic_init(&view->indexed, 0);
+    atomic_init(&view->complete, false);
+    atomic_init(&view->stop, false);
+
+    /* Index large buffers in the background (in place if no thread) */
+    if (len >= OCFX_TEXT_VIEW_SYNC_BYTES &&
+        pthread_create(&view->thread, NULL, index_main, view) == 0) {
+        view->threaded = true;
+    } else {
+        index_lines(view);
+    }
+    return view;
+}
+
+ocfx_text_view_t* ocfx_text_view_create(ocfx_font_t *font, const char *text, size_t len) {
+    if (!font || (!text && len > 0)) return NULL;
+    return create_view(font, text, len, false);
+}
+
+ocfx_text_view_t* ocfx_text_view_open(ocfx_font_t *font, const char *path) {
+    if (!font || !path) return NULL;
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        fprintf(stderr, "OCFX: Failed to open %s\n", path);
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        return NULL;
+    }
+
+    /* An empty file has nothing to map */
+    if (st.st_size == 0) {
+        close(fd);
+        return create_view(font, NULL, 0, false);
+    }
+
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        fprintf(stderr, "OCFX: Failed to map %s\n", path);
+        return NULL;
+    }
+
+    ocfx_text_view_t *view = create_view(font, data, (size_t)st.st_size, true);
+    if (!view) munmap(data, (size_t)st.st_size);
+    return view;
+}
+
+void ocfx_text_view_destroy(ocfx_text_view_t *view) {
+    if (!view) return;
+
+    if (view->threaded) {
+        atomic_store_explicit(&view->stop, true, memory_order_relaxed);
+        pthread_join(view->thread, NULL);
+    }
+
+    for (size_t i = 0; i < view->chunk_slots; i++) free(view->chunks[i]);
+    free(view->chunks);
+    if (view->mapped) munmap((void *)view->text, view->len);
+    free(view);
+}
+
+size_t ocfx_text_view_line_count(ocfx_text_view_t *view, bool *complete) {
+    if (!view) {
+        if (complete) *complete = true;
+        return 0;
+    }
+    return known_lines(view, complete);
+}
+
+void ocfx_text_view_wait(ocfx_text_view_t *view) {
+    if (!view || !view->threaded) return;
+    pthread_join(view->thread, NULL);
+    view->threaded = false;
+}
+
+const char* ocfx_text_view_get_line(ocfx_text_view_t *view, size_t line, size_t *len) {
+    if (len) *len = 0;
+    if (!view) return NULL;
+
+    bool complete;
+    size_t indexed = index_state(view, &complete);
+    if (line >= indexed || (line + 1 == indexed && !complete)) return NULL;
+
+    /* The next line's start (or the end of the buffer) bounds this one */
+    size_t start = (size_t)line_start(view, line);
+    size_t end = line + 1 < indexed ? (size_t)line_start(view, line + 1) : view->len;
+    if (end > start && view->text[end - 1] == '\n') end--;
+    if (end > start && view->text[end - 1] == '\r') end--;
+
+    if (len) *len = end - start;
+    return view->text + start;
+}
+
+void ocfx_text_view_scroll_to(ocfx_text_view_t *view, size_t line) {
+    if (!view) return;
+    size_t lines = known_lines(view, NULL);
+    view->top = line < lines ? line : (lines ? lines - 1 : 0);
+}
+
+size_t ocfx_text_view_get_top(ocfx_text_view_t *view) {
+    return view ? view->top : 0;
+}
+
+void ocfx_text_view_draw(ocfx_renderer_t *renderer, ocfx_text_view_t *view,
+                         ocfx_rect_t rect, float line_spacing, ocfx_color_t color) {
+    if (!renderer || !view || rect.height <= 0.0f) return;
+
+    float line_height = (float)ocfx_font_get_height(view->font) *
+                        (line_spacing > 0.0f ? line_spacing : 1.0f);
+    if (line_height <= 0.0f) return;
+
+    size_t rows = (size_t)ceilf(rect.height / line_height);
+    float y = rect.y;
+    for (size_t line = view->top; line < view->top + rows; line++) {
+        size_t len;
+        const char *text = ocfx_text_view_get_line(view, line, &len);
+        if (!text) break;
+
+        /* Long lines stop at the right edge instead of costing their length */
+        len = ocfx_font_fit_n(view->font, text, len, rect.width);
+        ocfx_text_draw_n(renderer, view->font, text, len, rect.x, y, color);
+        y += line_height;
+    }
+}
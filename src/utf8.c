@@ -0,0 +1,263 @@
+/* OCFX - UTF-8 Decoding Implementation
+ * ASCII is consumed 16 or 32 bytes at a time; only multi-byte sequences
+ * and short ASCII runs between them take the per-character path. Loads
+ * never go past the end of the range, so views into larger buffers are
+ * safe.
+ */
+
+#include "utf8.h"
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define OCFX_UTF8_AVX2 1
+#endif
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define OCFX_UTF8_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define OCFX_UTF8_NEON 1
+#endif
+
+/* ============================================================================
+ * ASCII fast path
+ * ============================================================================ */
+
+/* Word with a zero byte or a byte >= 0x80 */
+static inline bool word_has_stop(uint64_t w) {
+    const uint64_t ones = 0x0101010101010101ull;
+    const uint64_t highs = 0x8080808080808080ull;
+    return ((w - ones) & ~w & highs) | (w & highs);
+}
+
+size_t ocfx_utf8_ascii_prefix(const char *text, size_t len) {
+    const uint8_t *s = (const uint8_t *)text;
+    size_t i = 0;
+
+#if defined(OCFX_UTF8_AVX2)
+    const __m256i zero32 = _mm256_setzero_si256();
+    for (; i + 32 <= len; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(s + i));
+        uint32_t stop = (uint32_t)_mm256_movemask_epi8(v) |
+                        (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, zero32));
+        if (stop) return i + (size_t)__builtin_ctz(stop);
+    }
+#endif
+#if defined(OCFX_UTF8_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+        uint32_t stop = (uint32_t)_mm_movemask_epi8(v) |
+                        (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero));
+        if (stop) return i + (size_t)__builtin_ctz(stop);
+    }
+#elif defined(OCFX_UTF8_NEON)
+    for (; i + 16 <= len; i += 16) {
+        uint8x16_t v = vld1q_u8(s + i);
+        if (vmaxvq_u8(v) >= 0x80 || vminvq_u8(v) == 0) break;
+    }
+#endif
+
+    /* Tail (and targets without SIMD): eight bytes at a time */
+    for (; i + 8 <= len; i += 8) {
+        uint64_t w;
+        memcpy(&w, s + i, 8);
+        if (word_has_stop(w)) break;
+    }
+    while (i < len && s[i] && s[i] < 0x80) i++;
+    return i;
+}
+
+/* Are the 16 bytes at s all in 0x01..0x7F? */
+static inline bool block_is_ascii(const uint8_t *s) {
+#if defined(OCFX_UTF8_SSE2)
+    __m128i v = _mm_loadu_si128((const __m128i *)s);
+    return ((uint32_t)_mm_movemask_epi8(v) |
+            (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128()))) == 0;
+#elif defined(OCFX_UTF8_NEON)
+    uint8x16_t v = vld1q_u8(s);
+    return vmaxvq_u8(v) < 0x80 && vminvq_u8(v) != 0;
+#else
+    uint64_t w0, w1;
+    memcpy(&w0, s, 8);
+    memcpy(&w1, s + 8, 8);
+    return !word_has_stop(w0) && !word_has_stop(w1);
+#endif
+}
+
+/* Widen n ASCII bytes to codepoints */
+static inline void widen_ascii(const uint8_t *s, size_t n, uint32_t *out) {
+    size_t i = 0;
+#if defined(OCFX_UTF8_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+        __m128i lo = _mm_unpacklo_epi8(v, zero);
+        __m128i hi = _mm_unpackhi_epi8(v, zero);
+        _mm_storeu_si128((__m128i *)(out + i), _mm_unpacklo_epi16(lo, zero));
+        _mm_storeu_si128((__m128i *)(out + i + 4), _mm_unpackhi_epi16(lo, zero));
+        _mm_storeu_si128((__m128i *)(out + i + 8), _mm_unpacklo_epi16(hi, zero));
+        _mm_storeu_si128((__m128i *)(out + i + 12), _mm_unpackhi_epi16(hi, zero));
+    }
+#elif defined(OCFX_UTF8_NEON)
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t v = vld1q_u8(s + i);
+        uint16x8_t lo = vmovl_u8(vget_low_u8(v));
+        uint16x8_t hi = vmovl_u8(vget_high_u8(v));
+        vst1q_u32(out + i, vmovl_u16(vget_low_u16(lo)));
+        vst1q_u32(out + i + 4, vmovl_u16(vget_high_u16(lo)));
+        vst1q_u32(out + i + 8, vmovl_u16(vget_low_u16(hi)));
+        vst1q_u32(out + i + 12, vmovl_u16(vget_high_u16(hi)));
+    }
+#endif
+    for (; i < n; i++) out[i] = s[i];
+}
+
+/* ============================================================================
+ * Multi-byte sequences
+ * ============================================================================ */
+
+/* Decode one sequence at s (s < end, *s != 0). Returns its length, or 0
+ * for a bad or truncated continuation. Overlong forms are not rejected;
+ * callers treat an overlong NUL like a NUL byte. */
+static inline size_t decode_one(const uint8_t *s, const uint8_t *end, uint32_t *codepoint) {
+    size_t avail = (size_t)(end - s);
+
+    /* 1-byte sequence: 0xxxxxxx */
+    if ((*s & 0x80) == 0) {
+        *codepoint = *s;
+        return 1;
+    }
+    /* 2-byte sequence: 110xxxxx 10xxxxxx */
+    if ((*s & 0xE0) == 0xC0) {
+        if (avail < 2 || (s[1] & 0xC0) != 0x80) return 0;
+        *codepoint = ((uint32_t)(s[0] & 0x1F) << 6) | (s[1] & 0x3F);
+        return 2;
+    }
+    /* 3-byte sequence: 1110xxxx 10xxxxxx 10xxxxxx */
+    if ((*s & 0xF0) == 0xE0) {
+        if (avail < 3 || (s[1] & 0xC0) != 0x80 || (s[2] & 0xC0) != 0x80) return 0;
+        *codepoint = ((uint32_t)(s[0] & 0x0F) << 12) | ((uint32_t)(s[1] & 0x3F) << 6) |
+                     (s[2] & 0x3F);
+        return 3;
+    }
+    /* 4-byte sequence: 11110xxx 10xxxxxx 10xxxxxx 10xxxxxx */
+    if ((*s & 0xF8) == 0xF0) {
+        if (avail < 4 || (s[1] & 0xC0) != 0x80 || (s[2] & 0xC0) != 0x80 ||
+            (s[3] & 0xC0) != 0x80) {
+            return 0;
+        }
+        *codepoint = ((uint32_t)(s[0] & 0x07) << 18) | ((uint32_t)(s[1] & 0x3F) << 12) |
+                     ((uint32_t)(s[2] & 0x3F) << 6) | (s[3] & 0x3F);
+        return 4;
+    }
+    /* Invalid lead byte: skip it */
+    *codepoint = '?';
+    return 1;
+}
+
+/* Length of the sequence at s as decode_one would consume it, or 0 where
+ * decoding stops (including an overlong NUL). Skips assembling the value. */
+static inline size_t sequence_length(const uint8_t *s, const uint8_t *end) {
+    size_t avail = (size_t)(end - s);
+    uint8_t lead = *s;
+    size_t bytes;
+
+    if (lead < 0xC0 || lead >= 0xF8) return 1;    /* Stray continuation or invalid lead */
+    bytes = lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : 4;
+    if (avail < bytes) return 0;
+
+    uint8_t bits = 0;
+    for (size_t i = 1; i < bytes; i++) {
+        if ((s[i] & 0xC0) != 0x80) return 0;
+        bits |= s[i] & 0x3F;
+    }
+    if (bits == 0 && (lead & (0x7F >> bytes)) == 0) return 0;  /* Overlong NUL */
+    return bytes;
+}
+
+/* ============================================================================
+ * Internal API
+ * ============================================================================ */
+
+size_t ocfx_utf8_decode(const char **str, const char *end, uint32_t *out, size_t max) {
+    const uint8_t *s = (const uint8_t *)*str;
+    const uint8_t *e = (const uint8_t *)end;
+    size_t count = 0;
+
+    while (count < max && s < e) {
+        if (*s < 0x80) {
+            if (*s == 0) break;
+            /* Whole ASCII blocks go through the vector path */
+            if (e - s >= 16 && max - count >= 16 && block_is_ascii(s)) {
+                widen_ascii(s, 16, out + count);
+                s += 16;
+                count += 16;
+            } else {
+                out[count++] = *s++;
+            }
+            continue;
+        }
+
+        size_t bytes = decode_one(s, e, &out[count]);
+        if (bytes == 0 || out[count] == 0) break;
+        s += bytes;
+        count++;
+    }
+
+    *str = (const char *)s;
+    return count;
+}
+
+size_t ocfx_utf8_count(const char *text, size_t len) {
+    const uint8_t *s = (const uint8_t *)text;
+    const uint8_t *e = s + len;
+    size_t count = 0;
+
+    while (s < e) {
+        if (*s < 0x80) {
+            if (*s == 0) break;
+            if (e - s >= 16 && block_is_ascii(s)) {
+                size_t run = 16 + ocfx_utf8_ascii_prefix((const char *)s + 16,
+                                                         (size_t)(e - s) - 16);
+                s += run;
+                count += run;
+            } else {
+                s++;
+                count++;
+            }
+            continue;
+        }
+
+        size_t bytes = sequence_length(s, e);
+        if (bytes == 0) break;
+        s += bytes;
+        count++;
+    }
+    return count;
+}
+
+bool ocfx_utf8_validate(const char *text, size_t len) {
+    const uint8_t *s = (const uint8_t *)text;
+    const uint8_t *e = s + len;
+
+    while (s < e) {
+        if (*s < 0x80) {
+            if (*s == 0) return true;
+            if (e - s >= 16 && block_is_ascii(s)) {
+                s += 16 + ocfx_utf8_ascii_prefix((const char *)s + 16, (size_t)(e - s) - 16);
+            } else {
+                s++;
+            }
+            continue;
+        }
+
+        /* Unlike decoding, an invalid lead byte fails validation */
+        uint32_t codepoint;
+        size_t bytes = decode_one(s, e, &codepoint);
+        if (bytes <= 1) return false;
+        s += bytes;
+    }
+    return true;
+}
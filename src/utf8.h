@@ -0,0 +1,28 @@
+/* OCFX - UTF-8 Decoding (internal)
+ * Bulk decoding, counting and validation with a vectorized ASCII fast
+ * path (AVX2, SSE2 or NEON, picked at compile time; scalar otherwise).
+ *
+ * All functions stop at the end of the range, at a NUL byte, or at a
+ * malformed multi-byte sequence (bad or missing continuation byte). An
+ * invalid lead byte decodes as '?' and is skipped.
+ */
+
+#ifndef OCFX_UTF8_H
+#define OCFX_UTF8_H
+
+#include "ocfx/types.h"
+
+/* Decode up to max codepoints from [*str, end) into out, advancing *str.
+ * Returns the number decoded; 0 once the text is exhausted. */
+size_t ocfx_utf8_decode(const char **str, const char *end, uint32_t *out, size_t max);
+
+/* Codepoints in text[0, len) */
+size_t ocfx_utf8_count(const char *text, size_t len);
+
+/* True if text[0, len) (up to a NUL) is well formed */
+bool ocfx_utf8_validate(const char *text, size_t len);
+
+/* Length of the leading run of bytes in 0x01..0x7F */
+size_t ocfx_utf8_ascii_prefix(const char *text, size_t len);
+
+#endif /* OCFX_UTF8_H */
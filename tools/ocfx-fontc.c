@@ -0,0 +1,181 @@
+/* OCFX - Offline Font Compiler
+ * Rasterizes a TrueType/OpenType font at fixed sizes into baked strike
+ * files for ocfx_font_load_baked (no FreeType needed at runtime)
+ *
+ * Usage: ocfx-fontc [-sdf] [-w width] [-r first-last]... font.ttf prefix size...
+ * Writes prefix-<size>.ocfxf for every size. Default range: U+0020-U+007E.
+ */
+
+#include "strike.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+/* FreeType renders signed distance fields natively since 2.11 */
+#if FREETYPE_MAJOR > 2 || (FREETYPE_MAJOR == 2 && FREETYPE_MINOR >= 11)
+#define OCFX_HAVE_FT_SDF 1
+#endif
+
+#define FONTC_MAX_RANGES 64
+#define FONTC_MAX_HEIGHT 2048         /* Smallest GL_MAX_TEXTURE_SIZE of GLES 3.0 */
+
+/* Strike modes (must match ocfx_atlas_mode_t) */
+#define FONTC_MODE_BITMAP 0
+#define FONTC_MODE_SDF 1
+
+typedef struct {
+    uint32_t first, last;
+} codepoint_range_t;
+
+static void usage(void) {
+    fprintf(stderr,
+            "usage: ocfx-fontc [-sdf] [-w width] [-r first-last]... font.ttf prefix size...\n"
+            "  -sdf          bake signed distance fields instead of coverage bitmaps\n"
+            "  -w width      strike image width in pixels (default 1024)\n"
+            "  -r first-last codepoint range, hex (e.g. -r 20-7e -r a0-ff)\n");
+    exit(1);
+}
+
+/* Record an FT glyph index in the strike (once), returning its record */
+static bool add_glyph(FT_Face face, ocfx_strike_builder_t *builder, uint32_t mode,
+                      FT_UInt glyph_index, uint32_t *record) {
+    if (ocfx_strike_builder_find(builder, glyph_index, record)) return true;
+
+    if (mode == FONTC_MODE_SDF) {
+#ifdef OCFX_HAVE_FT_SDF
+        if (FT_Load_Glyph(face, glyph_index, FT_LOAD_DEFAULT) ||
+            FT_Render_Glyph(face->glyph, FT_RENDER_MODE_SDF)) {
+            return false;
+        }
+#else
+        return false;
+#endif
+    } else if (FT_Load_Glyph(face, glyph_index, FT_LOAD_RENDER)) {
+        return false;
+    }
+
+    FT_GlyphSlot slot = face->glyph;
+    *record = (uint32_t)builder->glyph_count;
+    return ocfx_strike_builder_add(builder, glyph_index, slot->bitmap.buffer,
+                                   (int)slot->bitmap.width, (int)slot->bitmap.rows,
+                                   slot->bitmap.pitch,
+                                   (float)slot->bitmap_left, (float)slot->bitmap_top,
+                                   (float)(slot->advance.x >> 6));
+}
+
+static bool bake_size(FT_Face face, const char *prefix, int size, uint32_t mode, int width,
+                      const codepoint_range_t *ranges, int range_count) {
+    if (FT_Set_Pixel_Sizes(face, 0, (FT_UInt)size)) {
+        fprintf(stderr, "ocfx-fontc: cannot set size %d\n", size);
+        return false;
+    }
+
+    ocfx_strike_builder_t builder;
+    ocfx_strike_builder_init(&builder, width, FONTC_MAX_HEIGHT);
+
+    /* Record 0 is .notdef: unmapped codepoints fall back to it */
+    uint32_t record = 0;
+    bool ok = add_glyph(face, &builder, mode, 0, &record);
+
+    for (int r = 0; ok && r < range_count; r++) {
+        for (uint32_t cp = ranges[r].first; ok && cp <= ranges[r].last; cp++) {
+            FT_UInt glyph_index = FT_Get_Char_Index(face, cp);
+            if (!glyph_index) continue;
+            ok = add_glyph(face, &builder, mode, glyph_index, &record) &&
+                 ocfx_strike_builder_map(&builder, cp, record);
+        }
+    }
+    if (!ok) {
+        fprintf(stderr, "ocfx-fontc: size %d does not fit a %dx%d strike image\n",
+                size, width, FONTC_MAX_HEIGHT);
+        ocfx_strike_builder_free(&builder);
+        return false;
+    }
+
+    ocfx_strike_header_t info = {
+        .size = size,
+        .mode = mode,
+        .height = (int32_t)(face->size->metrics.height >> 6),
+        .advance = (int32_t)(face->size->metrics.max_advance >> 6),
+        .ascent = (int32_t)(face->size->metrics.ascender >> 6),
+        .descent = (int32_t)(face->size->metrics.descender >> 6),
+    };
+
+    char path[4096];
+    snprintf(path, sizeof(path), "%s-%d.ocfxf", prefix, size);
+    ok = ocfx_strike_builder_write(&builder, path, &info);
+    if (ok) {
+        printf("%s: %zu glyphs, %zu codepoints, %dx%d\n", path, builder.glyph_count,
+               builder.cmap_count, builder.image_width,
+               builder.shelf_y + builder.shelf_height);
+    } else {
+        fprintf(stderr, "ocfx-fontc: cannot write %s\n", path);
+    }
+
+    ocfx_strike_builder_free(&builder);
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    codepoint_range_t ranges[FONTC_MAX_RANGES];
+    int range_count = 0;
+    uint32_t mode = FONTC_MODE_BITMAP;
+    int width = 1024;
+
+    int i = 1;
+    for (; i < argc && argv[i][0] == '-'; i++) {
+        if (strcmp(argv[i], "-sdf") == 0) {
+#ifndef OCFX_HAVE_FT_SDF
+            fprintf(stderr, "ocfx-fontc: SDF needs FreeType 2.11 or newer\n");
+            return 1;
+#endif
+            mode = FONTC_MODE_SDF;
+        } else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            width = atoi(argv[++i]);
+            if (width < 16 || width > FONTC_MAX_HEIGHT) usage();
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            unsigned first, last;
+            if (range_count == FONTC_MAX_RANGES ||
+                sscanf(argv[++i], "%x-%x", &first, &last) != 2 || first > last) {
+                usage();
+            }
+            ranges[range_count++] = (codepoint_range_t){first, last};
+        } else {
+            usage();
+        }
+    }
+    if (argc - i < 3) usage();
+
+    if (range_count == 0) {
+        ranges[range_count++] = (codepoint_range_t){0x20, 0x7e};
+    }
+
+    const char *font_path = argv[i++];
+    const char *prefix = argv[i++];
+
+    FT_Library library;
+    FT_Face face;
+    if (FT_Init_FreeType(&library)) {
+        fprintf(stderr, "ocfx-fontc: cannot initialize FreeType\n");
+        return 1;
+    }
+    if (FT_New_Face(library, font_path, 0, &face)) {
+        fprintf(stderr, "ocfx-fontc: cannot load %s\n", font_path);
+        FT_Done_FreeType(library);
+        return 1;
+    }
+
+    int status = 0;
+    for (; i < argc; i++) {
+        int size = atoi(argv[i]);
+        if (size <= 0 || !bake_size(face, prefix, size, mode, width, ranges, range_count)) {
+            status = 1;
+        }
+    }
+
+    FT_Done_Face(face);
+    FT_Done_FreeType(library);
+    return status;
+}